@@ -0,0 +1,22 @@
+#!/usr/bin/env bash
+
+SCRIPT_ROOT=$(pwd)
+BUILD=${BUILD:-release}
+PART=${PART:-both}
+
+if [ $# -lt 2 ]; then
+  echo "Expected at least 2 arguments"
+  echo "[PART=1|2|both] [BUILD=debug|release|pgo] $0 <DAY> <FILE...>"
+  echo
+  echo "Solves every file in one process and prints a 'file part answer us'"
+  echo "line per part, in the order the reads complete. The files are read"
+  echo "concurrently (io_uring, or preads with AOC_NO_URING) while solving."
+  exit 1
+fi
+
+DAY=$1
+shift
+
+make -s BUILD=$BUILD build/$BUILD/$DAY || exit 1
+
+printf '%s\n' "$@" | AOC_BATCH=files AOC_PART=$PART $SCRIPT_ROOT/build/$BUILD/$DAY
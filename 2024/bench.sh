@@ -0,0 +1,169 @@
+#!/usr/bin/env bash
+
+SCRIPT_ROOT=$(pwd)
+INPUT_DIR=$SCRIPT_ROOT/inputs
+SOURCE_DIR=$SCRIPT_ROOT/src
+HISTORY_FILE=${HISTORY_FILE:-$SCRIPT_ROOT/bench_history.tsv}
+RUNS=${RUNS:-10}
+BUILD=${BUILD:-release}
+
+function usage() {
+  echo "[BUILD=debug|release|pgo] $0 <DAY|all> [test]"
+  echo "$0 compare <BASELINE_COMMIT> [THRESHOLD_PERCENT] [CANDIDATE_COMMIT]"
+  echo
+  echo "Runs each day RUNS times (default 10) and appends the per part timing"
+  echo "stats to \$HISTORY_FILE (default bench_history.tsv), with days that parse"
+  echo "once also getting a \"parse\" record and days solving both parts in one"
+  echo "pass a \"both\" record instead of the parts. compare diffs the median"
+  echo "of the latest records of two commits and exits 1 if any part got slower"
+  echo "by more than THRESHOLD_PERCENT (default 5)."
+  exit 1
+}
+
+function commit_hash() {
+  local hash
+  hash=$(git -C "$SCRIPT_ROOT" rev-parse --short=12 HEAD 2>/dev/null || echo unknown)
+  if ! git -C "$SCRIPT_ROOT" diff --quiet HEAD -- "$SOURCE_DIR" 2>/dev/null; then
+    hash="$hash-dirty"
+  fi
+  echo "$hash"
+}
+
+# Prints "min median mean max stddev" of the numbers on stdin.
+function stats() {
+  sort -n | awk '
+    { v[NR] = $1; sum += $1; sumsq += $1 * $1 }
+    END {
+      if (NR == 0) { exit 1 }
+      median = NR % 2 ? v[(NR + 1) / 2] : (v[NR / 2] + v[NR / 2 + 1]) / 2
+      mean = sum / NR
+      var = sumsq / NR - mean * mean
+      printf "%d %.1f %.1f %d %.1f\n", v[1], median, mean, v[NR], (var > 0 ? sqrt(var) : 0)
+    }'
+}
+
+function bench_day() {
+  local day=$1
+  local input=$INPUT_DIR/$day
+  if [ ! -f "$input" ]; then
+    echo "Day $day: no input at $input, skipping"
+    return
+  fi
+
+  make -s BUILD=$BUILD build/$BUILD/$day || return 1
+
+  # Timings by section of the summary: "parse" for days with parse_input(),
+  # then the parts, or "both" for days solving them in one pass.
+  local -A times=()
+  for ((run = 0; run < RUNS; ++run)); do
+    while read -r section took; do
+      times[$section]+="$took "
+    done < <($SCRIPT_ROOT/build/$BUILD/$day <"$input" | awk -F '\t' '
+      $2 == "Parse" { section = "parse" }
+      $2 ~ /^Part [12]$/ { section = substr($2, 6) }
+      $2 ~ /^Both parts/ { section = "both" }
+      $3 ~ /^Took [0-9]+ us/ { split($3, took, " "); print section, took[2] }')
+    if [ -z "${times[both]}" ] && { [ -z "${times[1]}" ] || [ -z "${times[2]}" ]; }; then
+      echo "Day $day: could not find the timings in the output"
+      return 1
+    fi
+  done
+
+  local timestamp commit threads
+  timestamp=$(date -Iseconds)
+  commit=$(commit_hash)
+  threads=$(nproc)
+  for part in parse 1 2 both; do
+    if [ -z "${times[$part]}" ]; then
+      continue
+    fi
+    read -r min median mean max stddev < <(printf '%s\n' ${times[$part]} | stats)
+    printf 'Day %s part %s: median %s us (min %s, max %s, stddev %s) over %s runs\n' \
+      "$day" "$part" "$median" "$min" "$max" "$stddev" "$RUNS"
+    printf '%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\n' "$timestamp" \
+      "$commit" "$day" "$part" "$threads" "$RUNS" "$min" "$median" "$mean" \
+      "$max" "$stddev" "$BENCH_CXXFLAGS" >>"$HISTORY_FILE"
+  done
+}
+
+function compare() {
+  local baseline=$1
+  local threshold=${2:-5}
+  local candidate=$3
+  if [ ! -f "$HISTORY_FILE" ]; then
+    echo "No history at $HISTORY_FILE"
+    exit 1
+  fi
+  if [ -z "$candidate" ]; then
+    candidate=$(tail -n 1 "$HISTORY_FILE" | cut -f 2)
+  fi
+
+  # Commits match on prefix so both short and full hashes work. The latest
+  # record of each day and part wins.
+  awk -F '\t' -v baseline="$baseline" -v candidate="$candidate" \
+    -v threshold="$threshold" '
+    function matches(commit, wanted) {
+      return index(commit, wanted) == 1 || index(wanted, commit) == 1
+    }
+    matches($2, baseline) { base[$3 " " $4] = $8 }
+    matches($2, candidate) { cand[$3 " " $4] = $8 }
+    END {
+      printf "%-12s %14s %14s %9s\n", "Day/part", "baseline us", "candidate us", "change"
+      regressions = 0
+      n = 0
+      for (key in cand) {
+        if (key in base) { keys[++n] = key }
+      }
+      # Sort numerically by day, then part.
+      for (i = 2; i <= n; ++i) {
+        for (j = i; j > 1; --j) {
+          split(keys[j - 1], a, " ")
+          split(keys[j], b, " ")
+          if (a[1] + 0 < b[1] + 0 || (a[1] == b[1] && a[2] <= b[2])) { break }
+          tmp = keys[j]; keys[j] = keys[j - 1]; keys[j - 1] = tmp
+        }
+      }
+      for (i = 1; i <= n; ++i) {
+        key = keys[i]
+        change = base[key] > 0 ? (cand[key] - base[key]) / base[key] * 100 : 0
+        flag = ""
+        if (change > threshold) { flag = "  REGRESSION"; ++regressions }
+        split(key, dp, " ")
+        printf "%-12s %14.1f %14.1f %+8.1f%%%s\n", "Day " dp[1] "/" dp[2], base[key], cand[key], change, flag
+      }
+      if (n == 0) {
+        print "No day/part was benchmarked at both commits"
+        exit 1
+      }
+      exit (regressions > 0)
+    }' "$HISTORY_FILE"
+}
+
+if [ $# -eq 0 ]; then
+  usage
+fi
+
+if [ "$1" = compare ]; then
+  [ $# -ge 2 ] || usage
+  compare "$2" "$3" "$4"
+  exit $?
+fi
+
+if [ $# -gt 2 ]; then
+  usage
+fi
+
+if [ $# -eq 2 ] && [ "$2" = 'test' ]; then
+  INPUT_DIR=$SCRIPT_ROOT/samples
+fi
+
+BENCH_CXXFLAGS=$(make -s BUILD=$BUILD print-flags) || exit 1
+
+DAYS=$1
+if [ "$1" = all ]; then
+  DAYS=$(ls $SOURCE_DIR | sed -n 's/^\([0-9]*\)\.cpp$/\1/p' | sort -n)
+fi
+
+for day in $DAYS; do
+  bench_day "$day" || exit 1
+done
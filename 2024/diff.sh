@@ -0,0 +1,143 @@
+#!/usr/bin/env bash
+
+SCRIPT_ROOT=$(pwd)
+SOURCE_DIR=$SCRIPT_ROOT/src
+BUILD=${BUILD:-release}
+CASES=${CASES:-50}
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+if [ $# -gt 1 ]; then
+  echo "Expected at most 1 argument"
+  echo "[BUILD=debug|release|pgo] $0 [DAY]"
+  echo
+  echo "Checks that every implementation registered for the day agrees on the"
+  echo "samples, the real input and CASES (default 50) generated inputs of"
+  echo "growing size. The first input they disagree on is minimized and printed."
+  echo "Without a day it checks every day, and fails if any of them disagree"
+  echo "or have nothing to compare."
+  exit 1
+fi
+
+if [ $# -eq 0 ]; then
+  failed=()
+  for source in $(ls $SOURCE_DIR/[0-9]*.cpp | sort -V); do
+    day=$(basename $source .cpp)
+    "$0" $day || failed+=($day)
+  done
+  if [ ${#failed[@]} -gt 0 ]; then
+    echo "Failed: days ${failed[*]}"
+    exit 1
+  fi
+  exit 0
+fi
+
+DAY=$1
+
+# gen.sh arguments for a generated input of roughly size n.
+function gen_args() {
+  local n=$1
+  case $DAY in
+  1 | 2 | 7) echo "lines=$n" ;;
+  3) echo "lines=$((n / 8 + 1)) width=$((n * 8))" ;;
+  4) echo "size=$n" ;;
+  5) echo "updates=$n pages=$((n < 90 ? n + 3 : 90))" ;;
+  9) echo "length=$((n * 2 + 1))" ;;
+  11) echo "count=$n" ;;
+  *) echo "width=$n" ;;
+  esac
+}
+
+make -s BUILD=$BUILD build/$BUILD/$DAY || exit 1
+BINARY=$SCRIPT_ROOT/build/$BUILD/$DAY
+
+# Only true when the implementations disagree (exit 1), so candidates the day
+# crashes on don't count while minimizing. The redirect on the function keeps
+# bash's "Aborted" notices for those quiet.
+function disagrees() {
+  AOC_DIFF=1 $BINARY <"$1" >/dev/null 2>&1
+  [ $? -eq 1 ]
+} 2>/dev/null
+
+# Delta debugging: repeatedly drop chunks of lines (or characters, once only
+# one line is left) as long as the implementations still disagree.
+function minimize_units() {
+  local file=$1 unit=$2
+  if [ "$unit" = lines ]; then
+    mapfile -t units <"$file"
+  else
+    mapfile -t units < <(head -n 1 "$file" | grep -o .)
+  fi
+
+  local chunk=$(((${#units[@]} + 1) / 2))
+  while [ $chunk -ge 1 ] && [ ${#units[@]} -gt 1 ]; do
+    local start=0 reduced=0
+    while [ $start -lt ${#units[@]} ]; do
+      local candidate=("${units[@]:0:start}" "${units[@]:start+chunk}")
+      if [ "$unit" = lines ]; then
+        printf '%s\n' "${candidate[@]}" >"$WORK_DIR/candidate"
+      else
+        printf '%s' "${candidate[@]}" >"$WORK_DIR/candidate"
+        printf '\n' >>"$WORK_DIR/candidate"
+      fi
+      if [ ${#candidate[@]} -gt 0 ] && disagrees "$WORK_DIR/candidate"; then
+        units=("${candidate[@]}")
+        cp "$WORK_DIR/candidate" "$file"
+        reduced=1
+      else
+        start=$((start + chunk))
+      fi
+    done
+    if [ $reduced -eq 0 ]; then
+      chunk=$((chunk / 2))
+    fi
+  done
+}
+
+function report() {
+  local file=$1 name=$2
+  echo "Implementations disagree on $name"
+  cp "$file" "$WORK_DIR/minimized"
+  minimize_units "$WORK_DIR/minimized" lines
+  if [ "$(wc -l <"$WORK_DIR/minimized")" -le 1 ]; then
+    minimize_units "$WORK_DIR/minimized" chars
+  fi
+  echo "Minimized input ($(wc -c <"$WORK_DIR/minimized") bytes):"
+  cat "$WORK_DIR/minimized"
+  echo
+  AOC_DIFF=1 $BINARY <"$WORK_DIR/minimized"
+  exit 1
+}
+
+function check() {
+  local file=$1 name=$2
+  AOC_DIFF=1 $BINARY <"$file" >"$WORK_DIR/output" 2>&1
+  case $? in
+  0) ;;
+  1) report "$file" "$name" ;;
+  2)
+    # NOTHING_TO_COMPARE in util.hpp.
+    echo "Day $DAY registers no variants or solve_both, nothing to compare"
+    exit 1
+    ;;
+  *)
+    echo "Day $DAY crashed on $name:"
+    cat "$WORK_DIR/output"
+    exit 1
+    ;;
+  esac
+}
+
+for file in $SCRIPT_ROOT/samples/$DAY $SCRIPT_ROOT/inputs/$DAY; do
+  if [ -f "$file" ]; then
+    check "$file" "$file"
+  fi
+done
+
+for ((seed = 1; seed <= CASES; ++seed)); do
+  args="seed=$seed $(gen_args $((seed + 2)))"
+  $SCRIPT_ROOT/gen.sh $DAY $args >"$WORK_DIR/generated" || exit 1
+  check "$WORK_DIR/generated" "gen.sh $DAY $args"
+done
+
+echo "Day $DAY: all implementations agree on $CASES generated inputs"
@@ -0,0 +1,18 @@
+#!/usr/bin/env bash
+
+SCRIPT_ROOT=$(pwd)
+
+if [ $# -eq 0 ]; then
+  echo "Expected at least 1 argument"
+  echo "$0 <DAY> [key=value...] > generated/<DAY>"
+  echo "See src/gen.cpp for the keys each day understands, e.g."
+  echo "$0 6 width=10000 density=0.05 seed=7"
+  exit 1
+fi
+
+BUILD=${BUILD:-release}
+
+# stdout is the generated input.
+make -s BUILD=$BUILD build/$BUILD/gen >&2 || exit 1
+
+exec $SCRIPT_ROOT/build/$BUILD/gen "$@"
@@ -0,0 +1,25 @@
+#!/usr/bin/env bash
+
+SCRIPT_ROOT=$(pwd)
+INPUT_DIR=$SCRIPT_ROOT/inputs
+# host.cpp reads it to build the day with the same profile.
+export BUILD=${BUILD:-release}
+
+if [ $# -eq 0 ] || [ $# -gt 2 ]; then
+  echo "Expected 1 or 2 arguments"
+  echo "[BUILD=debug|release|pgo] $0 <DAY>"
+  echo "[BUILD=debug|release|pgo] $0 <DAY> test"
+  echo
+  echo "Keeps the input loaded and re-runs the day on every save of"
+  echo "src/<DAY>.cpp or a header, reloading it as a shared object."
+  exit 1
+fi
+
+DAY=$1
+if [ $# -eq 2 ] && [ $2 = 'test' ]; then
+  INPUT_DIR=$SCRIPT_ROOT/samples
+fi
+
+make -s BUILD=$BUILD build/$BUILD/host || exit 1
+
+exec $SCRIPT_ROOT/build/$BUILD/host $DAY $INPUT_DIR/$DAY
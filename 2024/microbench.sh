@@ -0,0 +1,12 @@
+#!/usr/bin/env bash
+
+SCRIPT_ROOT=$(pwd)
+BUILD=${BUILD:-release}
+
+# Usage: [BUILD=debug|release|pgo] microbench.sh [FILTER...]
+# Builds and runs the util.hpp microbenchmarks, only those whose name contains
+# one of the filters when any are given, e.g. `microbench.sh CharGrid split`.
+
+make -s BUILD=$BUILD build/$BUILD/microbench || exit 1
+
+exec $SCRIPT_ROOT/build/$BUILD/microbench "$@"
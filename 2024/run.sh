@@ -3,16 +3,16 @@
 SCRIPT_ROOT=$(pwd)
 INPUT_DIR=$SCRIPT_ROOT/inputs
 SOURCE_DIR=$SCRIPT_ROOT/src
+BUILD=${BUILD:-release}
 
 [ -d $INPUT_DIR ] || mkdir $INPUT_DIR
 [ -d $SOURCE_DIR ] || mkdir $SOURCE_DIR
 [ -d $SCRIPT_ROOT/samples ] || mkdir $SCRIPT_ROOT/samples
-[ -d $SCRIPT_ROOT/bin ] || mkdir $SCRIPT_ROOT/bin
 
 if [[ $# -eq 0 ]] || [[ $# -gt 2 ]]; then
   echo "Expected 1 or 2 arguments"
-  echo "$0 <DAY>"
-  echo "$0 <DAY> test"
+  echo "[BUILD=debug|release|pgo] $0 <DAY>"
+  echo "[BUILD=debug|release|pgo] $0 <DAY> test"
   exit 1
 fi
 
@@ -112,48 +112,7 @@ auto part_two(const string &input) -> expected<AnswerType, string> {
   return result;
 }
 
-int main() {
-  std::ostringstream buffer;
-  buffer << std::cin.rdbuf();
-  string input = buffer.str();
-
-  println(cout, " --- PART 1 LOGS ---");
-  reset_timer();
-  AnswerType part_one_result =
-      part_one(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_one_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
-
-  println(cout, " --- PART 2 LOGS ---");
-  reset_timer();
-  AnswerType part_two_result =
-      part_two(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_two_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
-
-  println(cout, "-----------------------------------------");
-  println(cout, "Day $DAY");
-  println(cout, "\tPart 1");
-  println(cout, "\t\tAnswer: {}", part_one_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_one_took_microseconds, float(part_one_took_microseconds)/1000.0, float(part_one_took_microseconds) / 1000000.0);
-  println(cout, "\tPart 2");
-  println(cout, "\t\tAnswer: {}", part_two_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_two_took_microseconds, float(part_two_took_microseconds)/1000.0, float(part_two_took_microseconds) / 1000000.0);
-  println(cout, "-----------------------------------------");
-  return 0;
-}
+int main() { return run_day<AnswerType>($DAY, part_one, part_two); }
 EOF
 } >$SOURCE_DIR/${DAY}.cpp
 
@@ -161,13 +120,7 @@ if [ ! -f "$SOURCE_DIR/${DAY}.cpp" ]; then
   make_file
 fi
 
-if [ -f $SCRIPT_ROOT/bin/$DAY ]; then
-  rm $SCRIPT_ROOT/bin/$DAY 2>/dev/null
-fi
-
-g++ -g -O3 -std=c++23 -I $SOURCE_DIR $SOURCE_DIR/${DAY}.cpp -o $SCRIPT_ROOT/bin/$DAY
+make -s BUILD=$BUILD build/$BUILD/$DAY || exit 1
 
-if [ $? -eq 0 ]; then
-  clear
-  gdb -q -ex run -ex "bt" -ex quit --args $SCRIPT_ROOT/bin/$DAY <$INPUT_DIR/$DAY
-fi
+clear
+gdb -q -ex run -ex "bt" -ex quit --args $SCRIPT_ROOT/build/$BUILD/$DAY <$INPUT_DIR/$DAY
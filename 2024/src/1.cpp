@@ -1,6 +1,7 @@
+#include <algorithm>
 #include <expected>
 #include <iostream>
-#include <sstream>
+#include <string_view>
 
 #include "util.hpp"
 
@@ -10,53 +11,45 @@ using std::unexpected, std::expected;
 
 typedef int AnswerType;
 
-auto part_one(const string &input) -> expected<int, string> {
+struct Lists {
+  // Both sorted.
   std::vector<int> left, right;
+};
 
-  std::istringstream lines(input);
-  string line;
-  while (std::getline(lines, line)) {
+constexpr auto parse_input(std::string_view input) -> expected<Lists, string> {
+  Lists lists;
+  for (const auto line : split_lines(input)) {
     std::vector<int> parts = split(line, ' ', parse::to_int);
     if (parts.size() != 2) {
       return unexpected(
           std::format("expected 2 parts per line, got {}", parts.size()));
     }
 
-    left.emplace_back(parts.at(0));
-    right.emplace_back(parts.at(1));
+    lists.left.emplace_back(parts.at(0));
+    lists.right.emplace_back(parts.at(1));
   }
 
-  std::sort(left.begin(), left.end());
-  std::sort(right.begin(), right.end());
+  std::sort(lists.left.begin(), lists.left.end());
+  std::sort(lists.right.begin(), lists.right.end());
+  return lists;
+}
 
+constexpr auto part_one(const Lists &lists) -> expected<int, string> {
   int sum_differences = 0;
-  for (int i = 0; i < left.size(); i++) {
-    sum_differences += abs(left.at(i) - right.at(i));
+  for (int i = 0; i < lists.left.size(); i++) {
+    const int difference = lists.left.at(i) - lists.right.at(i);
+    sum_differences += difference < 0 ? -difference : difference;
   }
 
   return sum_differences;
 }
 
-auto part_two(const string &input) -> expected<int, string> {
-  std::vector<int> left, right;
-
-  std::istringstream lines(input);
-  string line;
-  while (std::getline(lines, line)) {
-    auto parts = split(line, ' ', parse::to_int);
-    if (parts.size() != 2) {
-      return unexpected(
-          std::format("expected 2 parts per line, got {}", parts.size()));
-    }
-
-    left.emplace_back(parts.at(0));
-    right.emplace_back(parts.at(1));
-  }
-
+auto part_two_reference(const Lists &lists) -> expected<int, string> {
   int sum_similarity = 0;
 
-  for (const auto value : left) {
-    int occurrences = std::count(right.begin(), right.end(), value);
+  for (const auto value : lists.left) {
+    int occurrences =
+        std::count(lists.right.begin(), lists.right.end(), value);
     int similarity = value * occurrences;
     sum_similarity += similarity;
   }
@@ -64,50 +57,30 @@ auto part_two(const string &input) -> expected<int, string> {
   return sum_similarity;
 }
 
-int main() {
-  std::ostringstream buffer;
-  buffer << std::cin.rdbuf();
-  string input = buffer.str();
-
-  println(cout, " --- PART 1 LOGS ---");
-  reset_timer();
-  AnswerType part_one_result =
-      part_one(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_one_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
-
-  println(cout, " --- PART 2 LOGS ---");
-  reset_timer();
-  AnswerType part_two_result =
-      part_two(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_two_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
+// Same as part_two_reference, but walks both sorted lists together instead of
+// scanning the right list for every value on the left. Unlike a hash map that
+// also works at compile time.
+constexpr auto part_two(const Lists &lists) -> expected<int, string> {
+  const auto &right = lists.right;
+  int sum_similarity = 0;
+  size_t first = 0;
+  for (const auto value : lists.left) {
+    while (first < right.size() && right[first] < value) {
+      ++first;
+    }
+    size_t last = first;
+    while (last < right.size() && right[last] == value) {
+      ++last;
+    }
+    sum_similarity += value * int(last - first);
+  }
 
-  println(cout, "-----------------------------------------");
-  println(cout, "Day 1");
-  println(cout, "\tPart 1");
-  println(cout, "\t\tAnswer: {}", part_one_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_one_took_microseconds,
-          float(part_one_took_microseconds) / 1000.0,
-          float(part_one_took_microseconds) / 1000000.0);
-  println(cout, "\tPart 2");
-  println(cout, "\t\tAnswer: {}", part_two_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_two_took_microseconds,
-          float(part_two_took_microseconds) / 1000.0,
-          float(part_two_took_microseconds) / 1000000.0);
-  println(cout, "-----------------------------------------");
-  return 0;
+  return sum_similarity;
 }
 
+int main() {
+  independent_parts = true;
+  return run_day<AnswerType, parse_input, part_one, part_two>(
+      1, {{2, "reference",
+           parsed_part<AnswerType>(parse_input, part_two_reference)}});
+}
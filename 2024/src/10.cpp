@@ -4,9 +4,10 @@
 #include <expected>
 #include <format>
 #include <iostream>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_set>
+#include <vector>
 
 #include "util.hpp"
 
@@ -16,157 +17,138 @@ using std::unexpected, std::expected;
 
 typedef uint64_t AnswerType;
 
-std::unordered_set<Point> solve_part_one_recurse(const CharGrid &grid, int x,
-                                                 int y) {
-  std::unordered_set<Point> result;
-  char current = grid.at(x, y);
-  if (current == '9') {
-    result.insert({x, y});
-    return result;
-  }
-
-  if (grid.contains(x + 1, y) && grid.at(x + 1, y) == current + 1) {
-    for (const Point &p : solve_part_one_recurse(grid, x + 1, y)) {
-      result.insert(p);
-    }
-  }
-  if (grid.contains(x - 1, y) && grid.at(x - 1, y) == current + 1) {
-    for (const Point &p : solve_part_one_recurse(grid, x - 1, y)) {
-      result.insert(p);
-    }
-  }
-  if (grid.contains(x, y + 1) && grid.at(x, y + 1) == current + 1) {
-    for (const Point &p : solve_part_one_recurse(grid, x, y + 1)) {
-      result.insert(p);
-    }
-  }
-  if (grid.contains(x, y - 1) && grid.at(x, y - 1) == current + 1) {
-    for (const Point &p : solve_part_one_recurse(grid, x, y - 1)) {
-      result.insert(p);
+auto parse_input(std::string_view input) -> CharGrid { return CharGrid(input); }
+
+// The score of a trailhead is the number of 9s reachable from it, going up
+// one at a time. Trailheads are scored in bands of rows on the thread pool. A
+// trail reaches at most 9 rows past its band, so each band's search only
+// covers its read rows.
+auto part_one(const CharGrid &grid) -> expected<AnswerType, string> {
+  const auto uphill = [&](const Point &from, const Point &to) {
+    return grid(to.x, to.y) == grid(from.x, from.y) + 1;
+  };
+  return parallel_for_rows(grid, 9, [&](const RowBand &band) {
+    AnswerType result = 0;
+    GridSearch search(grid, band.read_begin, band.read_end);
+    const auto count_nines = [&](const Point &cell) {
+      result += grid(cell.x, cell.y) == '9';
+    };
+    for (size_t y = band.begin; y < band.end; ++y) {
+      for (const auto &[x, c] : std::views::enumerate(grid.row(y))) {
+        if (c == '0') {
+          search.fill(Point(x, y), uphill, count_nines);
+          search.reset();
+        }
+      }
     }
-  }
-
-  return result;
+    return result;
+  });
 }
 
-auto solve_part_one(const CharGrid &grid) -> AnswerType {
-  AnswerType result = 0;
-  int x = 0;
-  int y = 0;
-
-  for (const char c : grid.vec) {
-    if (c == '0') {
-      result += solve_part_one_recurse(grid, x, y).size();
-    }
+// The rating of a trailhead is the number of trails from it to a 9. A cell's
+// trails are the trails of its neighbors one higher, so going from the 9s
+// down counts them all in a pass per height instead of walking each trail.
+auto part_two(const CharGrid &grid) -> expected<AnswerType, string> {
+  // Laid out like the padded grid, so neighbors are the same offset apart. A
+  // cell has at most 4^9 trails, so 32 bits are enough and halve the memory.
+  std::vector<uint32_t> trails(grid.stride * (grid.height + 2 * grid.padding));
+  uint32_t *origin = trails.data() + grid.index(grid.padding, grid.padding);
+  const auto neighbors = grid.neighbors4();
 
-    ++x;
-    if (x >= grid.width) {
-      ++y;
-      x = 0;
+  AnswerType result = 0;
+  for (char height = '9'; height >= '0'; --height) {
+    for (size_t y = 0; y < grid.height; ++y) {
+      const ptrdiff_t row = grid.index(0, y);
+      for (ptrdiff_t i = row; i < row + ptrdiff_t(grid.width); ++i) {
+        if (grid[i] != height) {
+          continue;
+        }
+        if (height == '9') {
+          origin[i] = 1;
+          continue;
+        }
+        // The border never counts, as it is never one higher.
+        for (const ptrdiff_t neighbor : neighbors) {
+          origin[i] +=
+              (grid[i + neighbor] == height + 1) * origin[i + neighbor];
+        }
+        if (height == '0') {
+          result += origin[i];
+        }
+      }
     }
   }
   return result;
 }
 
-auto part_one(const std::string &input) -> expected<AnswerType, string> {
-  AnswerType result = 0;
-  auto grid = CharGrid(input);
-  result = solve_part_one(grid);
-  return result;
+// The recursive walks the search and the pass per height replaced, following
+// every trail from every trailhead. They only go 10 deep, but the number of
+// trails can grow as 4^9 per trailhead, so they are for the samples and
+// generated inputs.
+void collect_nines(const CharGrid &grid, int x, int y,
+                   std::unordered_set<Point> &nines) {
+  const char current = grid.at(x, y);
+  if (current == '9') {
+    nines.insert({x, y});
+    return;
+  }
+  for (const auto &[dx, dy] : STEPS4) {
+    const int next_x = x + dx, next_y = y + dy;
+    if (grid.contains(next_x, next_y) &&
+        grid.at(next_x, next_y) == current + 1) {
+      collect_nines(grid, next_x, next_y, nines);
+    }
+  }
 }
 
-AnswerType solve_part_two_recurse(const CharGrid &grid, int x, int y) {
-  AnswerType result = 0;
-  char current = grid.at(x, y);
+AnswerType count_trails(const CharGrid &grid, int x, int y) {
+  const char current = grid.at(x, y);
   if (current == '9') {
     return 1;
   }
-
-  if (grid.contains(x + 1, y) && grid.at(x + 1, y) == current + 1) {
-    result += solve_part_two_recurse(grid, x + 1, y);
-  }
-  if (grid.contains(x - 1, y) && grid.at(x - 1, y) == current + 1) {
-    result += solve_part_two_recurse(grid, x - 1, y);
-  }
-  if (grid.contains(x, y + 1) && grid.at(x, y + 1) == current + 1) {
-    result += solve_part_two_recurse(grid, x, y + 1);
-  }
-  if (grid.contains(x, y - 1) && grid.at(x, y - 1) == current + 1) {
-    result += solve_part_two_recurse(grid, x, y - 1);
+  AnswerType result = 0;
+  for (const auto &[dx, dy] : STEPS4) {
+    const int next_x = x + dx, next_y = y + dy;
+    if (grid.contains(next_x, next_y) &&
+        grid.at(next_x, next_y) == current + 1) {
+      result += count_trails(grid, next_x, next_y);
+    }
   }
-
   return result;
 }
 
-auto solve_part_two(const CharGrid &grid) -> AnswerType {
+auto part_one_reference(const CharGrid &grid) -> expected<AnswerType, string> {
   AnswerType result = 0;
-  int x = 0;
-  int y = 0;
-
-  for (const char c : grid.vec) {
-    if (c == '0') {
-      result += solve_part_two_recurse(grid, x, y);
-    }
-
-    ++x;
-    if (x >= grid.width) {
-      ++y;
-      x = 0;
+  for (size_t y = 0; y < grid.height; ++y) {
+    for (size_t x = 0; x < grid.width; ++x) {
+      if (grid(x, y) == '0') {
+        std::unordered_set<Point> nines;
+        collect_nines(grid, x, y, nines);
+        result += nines.size();
+      }
     }
   }
   return result;
 }
 
-auto part_two(const string &input) -> expected<AnswerType, string> {
+auto part_two_reference(const CharGrid &grid) -> expected<AnswerType, string> {
   AnswerType result = 0;
-  auto grid = CharGrid(input);
-  result = solve_part_two(grid);
+  for (size_t y = 0; y < grid.height; ++y) {
+    for (size_t x = 0; x < grid.width; ++x) {
+      if (grid(x, y) == '0') {
+        result += count_trails(grid, x, y);
+      }
+    }
+  }
   return result;
 }
 
 int main() {
-  std::ostringstream buffer;
-  buffer << std::cin.rdbuf();
-  string input = buffer.str();
-
-  println(cout, " --- PART 1 LOGS ---");
-  reset_timer();
-  AnswerType part_one_result =
-      part_one(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_one_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
-
-  println(cout, " --- PART 2 LOGS ---");
-  reset_timer();
-  AnswerType part_two_result =
-      part_two(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_two_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
-
-  println(cout, "-----------------------------------------");
-  println(cout, "Day 10");
-  println(cout, "\tPart 1");
-  println(cout, "\t\tAnswer: {}", part_one_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_one_took_microseconds,
-          float(part_one_took_microseconds) / 1000.0,
-          float(part_one_took_microseconds) / 1000000.0);
-  println(cout, "\tPart 2");
-  println(cout, "\t\tAnswer: {}", part_two_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_two_took_microseconds,
-          float(part_two_took_microseconds) / 1000.0,
-          float(part_two_took_microseconds) / 1000000.0);
-  println(cout, "-----------------------------------------");
-  return 0;
+  independent_parts = true;
+  return run_day<AnswerType>(
+      10, parse_input, part_one, part_two,
+      {{1, "reference",
+        parsed_part<AnswerType>(parse_input, part_one_reference)},
+       {2, "reference",
+        parsed_part<AnswerType>(parse_input, part_two_reference)}});
 }
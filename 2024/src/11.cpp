@@ -4,9 +4,9 @@
 #include <expected>
 #include <format>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <string>
-#include <unordered_map>
 
 #include "util.hpp"
 
@@ -16,15 +16,17 @@ using std::unexpected, std::expected;
 
 typedef uint64_t AnswerType;
 
-std::unordered_map<std::pair<uint64_t, uint64_t>, uint64_t> cache;
+// Shared by both parts, part two reuses what part one counted. That's also why
+// they don't declare independent_parts.
+FlatMap<std::pair<uint64_t, uint64_t>, uint64_t> cache;
 
 AnswerType solve_recurse(uint64_t stone, uint64_t blinks) {
   if (blinks == 0) {
     return 1;
   }
   auto key = std::make_pair(stone, blinks);
-  if (cache.contains(key)) {
-    return cache.at(key);
+  if (const auto it = cache.find(key); it != cache.end()) {
+    return it->second;
   }
   AnswerType result = 0;
   if (stone == 0) {
@@ -39,7 +41,7 @@ AnswerType solve_recurse(uint64_t stone, uint64_t blinks) {
       result += solve_recurse(stone * 2024, blinks - 1);
     }
   }
-  cache.insert_or_assign(key, result);
+  cache[key] = result;
   return result;
 }
 
@@ -60,49 +62,47 @@ auto part_two(const string &input) -> expected<AnswerType, string> {
   return solve(input, 75);
 }
 
-int main() {
-  std::ostringstream buffer;
-  buffer << std::cin.rdbuf();
-  string input = buffer.str();
+// Blinks all the stones at once, counting how many of each there are, with
+// the digits split as text. Slower, but shares no cache or digit math with the
+// recursion.
+AnswerType solve_reference(const std::string &input, int blinks) {
+  std::map<uint64_t, AnswerType> stones;
+  for (const auto stone : split(input, ' ', parse::to_uint64)) {
+    ++stones[stone];
+  }
+  for (int i = 0; i < blinks; ++i) {
+    std::map<uint64_t, AnswerType> next;
+    for (const auto &[stone, count] : stones) {
+      const string digits = std::to_string(stone);
+      if (stone == 0) {
+        next[1] += count;
+      } else if (digits.size() % 2 == 0) {
+        const size_t half = digits.size() / 2;
+        next[std::stoull(digits.substr(0, half))] += count;
+        next[std::stoull(digits.substr(half))] += count;
+      } else {
+        next[stone * 2024] += count;
+      }
+    }
+    stones = std::move(next);
+  }
+  AnswerType result = 0;
+  for (const auto &[stone, count] : stones) {
+    result += count;
+  }
+  return result;
+}
 
-  println(cout, " --- PART 1 LOGS ---");
-  reset_timer();
-  AnswerType part_one_result =
-      part_one(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_one_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
+auto part_one_reference(const string &input) -> expected<AnswerType, string> {
+  return solve_reference(input, 25);
+}
 
-  println(cout, " --- PART 2 LOGS ---");
-  reset_timer();
-  AnswerType part_two_result =
-      part_two(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_two_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
+auto part_two_reference(const string &input) -> expected<AnswerType, string> {
+  return solve_reference(input, 75);
+}
 
-  println(cout, "-----------------------------------------");
-  println(cout, "Day 11");
-  println(cout, "\tPart 1");
-  println(cout, "\t\tAnswer: {}", part_one_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_one_took_microseconds,
-          float(part_one_took_microseconds) / 1000.0,
-          float(part_one_took_microseconds) / 1000000.0);
-  println(cout, "\tPart 2");
-  println(cout, "\t\tAnswer: {}", part_two_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_two_took_microseconds,
-          float(part_two_took_microseconds) / 1000.0,
-          float(part_two_took_microseconds) / 1000000.0);
-  println(cout, "-----------------------------------------");
-  return 0;
+int main() {
+  return run_day<AnswerType>(11, part_one, part_two,
+                             {{1, "reference", part_one_reference},
+                              {2, "reference", part_two_reference}});
 }
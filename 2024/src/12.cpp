@@ -4,9 +4,10 @@
 #include <expected>
 #include <format>
 #include <iostream>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_set>
+#include <utility>
 
 #include "util.hpp"
 
@@ -16,103 +17,78 @@ using std::unexpected, std::expected;
 
 typedef uint64_t AnswerType;
 
-std::unordered_set<std::pair<uint64_t, uint64_t>> visited;
+auto parse_input(std::string_view input) -> CharGrid { return CharGrid(input); }
 
-// perimeter, area
-std::pair<AnswerType, AnswerType>
-measure_recurse(const CharGrid &grid, const char regionId, int x, int y) {
-  auto key = std::make_pair(x, y);
-  bool contains = grid.contains(x, y);
-  char c = contains ? grid.at(x, y) : regionId;
-  if (visited.contains(key) && c == regionId) {
-    return std::make_pair(0, 0);
-  }
-  if (!contains || c != regionId) {
-    return std::make_pair(1, 0);
+// Floods each region in turn. Every side of a plot that doesn't face the same
+// region, the border included, is a piece of fence.
+auto part_one(const CharGrid &grid) -> expected<AnswerType, string> {
+  AnswerType result = 0;
+  GridSearch search(grid);
+  for (size_t y = 0; y < grid.height; ++y) {
+    for (const auto &[x, plant] : std::views::enumerate(grid.row(y))) {
+      const char region = plant;
+      AnswerType area = 0;
+      AnswerType perimeter = 0;
+      search.fill(
+          Point(x, y),
+          [&](const Point &, const Point &to) {
+            return grid(to.x, to.y) == region;
+          },
+          [&](const Point &plot) {
+            ++area;
+            for (const auto &[dx, dy] : STEPS4) {
+              perimeter += grid(plot.x + dx, plot.y + dy) != region;
+            }
+          });
+      result += area * perimeter;
+    }
   }
-  visited.insert(key);
-
-  std::pair<AnswerType, AnswerType> result{0, 1};
-  std::pair<AnswerType, AnswerType> tmp;
-  tmp = measure_recurse(grid, regionId, x + 1, y);
-  result.first += tmp.first;
-  result.second += tmp.second;
-  tmp = measure_recurse(grid, regionId, x - 1, y);
-  result.first += tmp.first;
-  result.second += tmp.second;
-  tmp = measure_recurse(grid, regionId, x, y + 1);
-  result.first += tmp.first;
-  result.second += tmp.second;
-  tmp = measure_recurse(grid, regionId, x, y - 1);
-  result.first += tmp.first;
-  result.second += tmp.second;
   return result;
 }
 
-std::pair<AnswerType, AnswerType> measure(const CharGrid &grid, int x, int y) {
-  return measure_recurse(grid, grid.at(x, y), x, y);
+auto part_two(const CharGrid &grid) -> expected<AnswerType, string> {
+  return unexpected("not implemented");
 }
 
-auto part_one(const std::string &input) -> expected<AnswerType, string> {
-  AnswerType result = 0;
-  CharGrid grid(input);
-  for (int x = 0; x < grid.width; ++x) {
-    for (int y = 0; y < grid.height; ++y) {
-      auto measurement = measure(grid, x, y);
-      result += measurement.first * measurement.second;
-    }
+// The recursive flood GridSearch replaced, one call per plot and per side
+// facing out. It recurses as deep as a region is big, so it is for the samples
+// and generated inputs.
+// perimeter, area
+std::pair<AnswerType, AnswerType>
+measure_recurse(const CharGrid &grid, char region, int x, int y,
+                std::unordered_set<Point> &visited) {
+  if (!grid.contains(x, y) || grid.at(x, y) != region) {
+    return {1, 0};
+  }
+  if (!visited.insert({x, y}).second) {
+    return {0, 0};
+  }
+  std::pair<AnswerType, AnswerType> result{0, 1};
+  for (const auto &[dx, dy] : STEPS4) {
+    const auto [perimeter, area] =
+        measure_recurse(grid, region, x + dx, y + dy, visited);
+    result.first += perimeter;
+    result.second += area;
   }
   return result;
 }
 
-auto part_two(const string &input) -> expected<AnswerType, string> {
+auto part_one_reference(const CharGrid &grid) -> expected<AnswerType, string> {
   AnswerType result = 0;
+  std::unordered_set<Point> visited;
+  for (size_t y = 0; y < grid.height; ++y) {
+    for (size_t x = 0; x < grid.width; ++x) {
+      const auto [perimeter, area] =
+          measure_recurse(grid, grid(x, y), x, y, visited);
+      result += perimeter * area;
+    }
+  }
   return result;
 }
 
 int main() {
-  std::ostringstream buffer;
-  buffer << std::cin.rdbuf();
-  string input = buffer.str();
-
-  println(cout, " --- PART 1 LOGS ---");
-  reset_timer();
-  AnswerType part_one_result =
-      part_one(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_one_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
-
-  println(cout, " --- PART 2 LOGS ---");
-  reset_timer();
-  AnswerType part_two_result =
-      part_two(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_two_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
-
-  println(cout, "-----------------------------------------");
-  println(cout, "Day 12");
-  println(cout, "\tPart 1");
-  println(cout, "\t\tAnswer: {}", part_one_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_one_took_microseconds,
-          float(part_one_took_microseconds) / 1000.0,
-          float(part_one_took_microseconds) / 1000000.0);
-  println(cout, "\tPart 2");
-  println(cout, "\t\tAnswer: {}", part_two_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_two_took_microseconds,
-          float(part_two_took_microseconds) / 1000.0,
-          float(part_two_took_microseconds) / 1000000.0);
-  println(cout, "-----------------------------------------");
-  return 0;
+  return run_day<AnswerType>(
+      12, parse_input, part_one, part_two,
+      {{1, "reference",
+        parsed_part<AnswerType>(parse_input, part_one_reference)}});
 }
@@ -1,7 +1,9 @@
 #include <expected>
 #include <iostream>
 #include <ranges>
-#include <sstream>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include "util.hpp"
 
@@ -11,7 +13,7 @@ using std::unexpected, std::expected;
 
 typedef int AnswerType;
 
-bool is_safe(std::ranges::range auto &parts) {
+constexpr bool is_safe(std::ranges::range auto &parts) {
   constexpr int DESCENDING = 1;
   constexpr int ASCENDING = -1;
 
@@ -41,13 +43,20 @@ bool is_safe(std::ranges::range auto &parts) {
   return true;
 }
 
-auto part_one(const string &input) -> expected<int, string> {
+typedef std::vector<std::vector<int>> Reports;
+
+constexpr auto parse_input(std::string_view input) -> Reports {
+  Reports reports;
+  for (const auto line : split_lines(input)) {
+    reports.push_back(split(line, ' ', parse::to_int));
+  }
+  return reports;
+}
+
+constexpr auto part_one(const Reports &reports) -> expected<int, string> {
   int result = 0;
 
-  std::istringstream lines(input);
-  string line;
-  while (std::getline(lines, line)) {
-    auto parts = split(line, ' ', parse::to_int);
+  for (const auto &parts : reports) {
     if (is_safe(parts)) {
       result++;
     }
@@ -56,70 +65,49 @@ auto part_one(const string &input) -> expected<int, string> {
   return result;
 }
 
-auto part_two(const string &input) -> expected<int, string> {
+// Whether the report is safe with at most one level removed.
+constexpr bool is_safe_dampened(const std::vector<int> &all_parts) {
+  for (int skip_index = 0; skip_index < all_parts.size(); ++skip_index) {
+    auto parts =
+        all_parts | std::views::filter([&, i = 0](const int &) mutable {
+          return i++ != skip_index;
+        });
+    if (is_safe(parts)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+constexpr auto part_two(const Reports &reports) -> expected<int, string> {
   int result = 0;
 
-  std::istringstream lines(input);
-  string line;
-  while (std::getline(lines, line)) {
-    auto all_parts = split(line, ' ', parse::to_int);
-    for (int skip_index = 0; skip_index < all_parts.size(); ++skip_index) {
-      auto parts =
-          all_parts | std::views::filter([&, i = 0](const int &) mutable {
-            return i++ != skip_index;
-          });
-      if (is_safe(parts)) {
-        result++;
-        break;
-      }
+  for (const auto &all_parts : reports) {
+    if (is_safe_dampened(all_parts)) {
+      result++;
+    }
+  }
+  return result;
+}
+
+// A report safe as is is also safe with the dampener, so only the unsafe ones
+// are checked again.
+constexpr auto solve_both(const Reports &reports)
+    -> expected<std::pair<int, int>, string> {
+  std::pair<int, int> result{0, 0};
+
+  for (const auto &parts : reports) {
+    if (is_safe(parts)) {
+      result.first++;
+      result.second++;
+    } else if (is_safe_dampened(parts)) {
+      result.second++;
     }
   }
   return result;
 }
 
 int main() {
-  std::ostringstream buffer;
-  buffer << std::cin.rdbuf();
-  string input = buffer.str();
-
-  println(cout, " --- PART 1 LOGS ---");
-  reset_timer();
-  AnswerType part_one_result =
-      part_one(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_one_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
-
-  println(cout, " --- PART 2 LOGS ---");
-  reset_timer();
-  AnswerType part_two_result =
-      part_two(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_two_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
-
-  println(cout, "-----------------------------------------");
-  println(cout, "Day 2");
-  println(cout, "\tPart 1");
-  println(cout, "\t\tAnswer: {}", part_one_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_one_took_microseconds,
-          float(part_one_took_microseconds) / 1000.0,
-          float(part_one_took_microseconds) / 1000000.0);
-  println(cout, "\tPart 2");
-  println(cout, "\t\tAnswer: {}", part_two_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_two_took_microseconds,
-          float(part_two_took_microseconds) / 1000.0,
-          float(part_two_took_microseconds) / 1000000.0);
-  println(cout, "-----------------------------------------");
-  return 0;
+  independent_parts = true;
+  return run_day<AnswerType, parse_input, part_one, part_two, solve_both>(2);
 }
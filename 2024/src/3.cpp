@@ -1,8 +1,12 @@
+#include <charconv>
 #include <expected>
 #include <format>
 #include <iostream>
+#include <optional>
 #include <regex>
 #include <sstream>
+#include <string_view>
+#include <utility>
 
 #include "util.hpp"
 
@@ -12,104 +16,130 @@ using std::unexpected, std::expected;
 
 typedef int AnswerType;
 
-auto part_one(const string &input) -> expected<AnswerType, string> {
-  AnswerType result = 0;
-  std::regex re(R"RE(mul\((\d+,\d+)\))RE", std::regex_constants::ECMAScript);
-  int submatches[] = {1};
-
-  std::istringstream lines(input);
-  string line;
-  while (std::getline(lines, line)) {
-    auto it =
-        std::sregex_token_iterator(line.begin(), line.end(), re, submatches);
-    auto end = std::sregex_token_iterator();
-    for (; it != end; ++it) {
-      const auto &match = *it;
-      auto s = match.str();
-      auto parts = split(s, ',', parse::to_int);
-      result += parts.at(0) * parts.at(1);
-    }
+// The product of the numbers in an "a,b" of digits, or nothing if one of them
+// doesn't fit in an AnswerType.
+std::optional<AnswerType> multiply(std::string_view s) {
+  const size_t comma = s.find(',');
+  AnswerType a = 0, b = 0;
+  const auto [a_end, a_error] = std::from_chars(s.data(), s.data() + comma, a);
+  const auto [b_end, b_error] =
+      std::from_chars(s.data() + comma + 1, s.data() + s.size(), b);
+  if (a_error != std::errc() || b_error != std::errc()) {
+    return std::nullopt;
   }
-  return result;
+  return a * b;
 }
 
-auto part_two(const string &input) -> expected<AnswerType, string> {
-  AnswerType result = 0;
+typedef std::pair<AnswerType, AnswerType> Sums;
+
+// The sum of every mul() for part one and of those do() and don't() leave
+// enabled for part two, from one scan of the whole input. An instruction can't
+// span lines, so they needn't be scanned one by one.
+auto scan(const string &input) -> expected<Sums, string> {
+  Sums result{0, 0};
   std::regex re(R"RE(mul\((\d+,\d+)\)|(do\(\))|(don't\(\)))RE",
                 std::regex_constants::ECMAScript);
   int submatches[] = {1, 2, 3};
   bool active = true;
 
-  std::istringstream lines(input);
-  string line;
-  while (std::getline(lines, line)) {
-    auto it =
-        std::sregex_token_iterator(line.begin(), line.end(), re, submatches);
-    auto end = std::sregex_token_iterator();
-    for (; it != end; ++it) {
-      const auto &match = *it;
-      if (!match.matched) {
-        continue;
-      }
+  auto it =
+      std::sregex_token_iterator(input.begin(), input.end(), re, submatches);
+  auto end = std::sregex_token_iterator();
+  for (; it != end; ++it) {
+    const auto &match = *it;
+    if (!match.matched) {
+      continue;
+    }
 
-      auto s = match.str();
-      if (s == "don't()") {
-        active = false;
-      } else if (s == "do()") {
-        active = true;
-      } else if (active) {
-        auto parts = split(s, ',', parse::to_int);
-        result += parts.at(0) * parts.at(1);
+    auto s = match.str();
+    if (s == "don't()") {
+      active = false;
+    } else if (s == "do()") {
+      active = true;
+    } else {
+      const auto product = multiply(s);
+      if (!product) {
+        return unexpected(std::format("mul({}) is out of range", s));
+      }
+      result.first += *product;
+      if (active) {
+        result.second += *product;
       }
     }
   }
   return result;
 }
 
-int main() {
-  std::ostringstream buffer;
-  buffer << std::cin.rdbuf();
-  string input = buffer.str();
+// One part's answer out of what scan() or scan_reference() returned.
+auto sum_of_part(int part, const expected<Sums, string> &sums)
+    -> expected<AnswerType, string> {
+  if (!sums) {
+    return unexpected(sums.error());
+  }
+  return part == 1 ? sums->first : sums->second;
+}
 
-  println(cout, " --- PART 1 LOGS ---");
-  reset_timer();
-  AnswerType part_one_result =
-      part_one(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_one_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
+auto part_one(const string &input) -> expected<AnswerType, string> {
+  return sum_of_part(1, scan(input));
+}
 
-  println(cout, " --- PART 2 LOGS ---");
-  reset_timer();
-  AnswerType part_two_result =
-      part_two(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_two_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
+auto part_two(const string &input) -> expected<AnswerType, string> {
+  return sum_of_part(2, scan(input));
+}
 
-  println(cout, "-----------------------------------------");
-  println(cout, "Day 3");
-  println(cout, "\tPart 1");
-  println(cout, "\t\tAnswer: {}", part_one_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_one_took_microseconds,
-          float(part_one_took_microseconds) / 1000.0,
-          float(part_one_took_microseconds) / 1000000.0);
-  println(cout, "\tPart 2");
-  println(cout, "\t\tAnswer: {}", part_two_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_two_took_microseconds,
-          float(part_two_took_microseconds) / 1000.0,
-          float(part_two_took_microseconds) / 1000000.0);
-  println(cout, "-----------------------------------------");
-  return 0;
+// The same scan without the regex, matching the instructions by hand.
+auto scan_reference(const string &input) -> expected<Sums, string> {
+  Sums result{0, 0};
+  bool active = true;
+  const std::string_view text = input;
+  for (size_t i = 0; i < text.size(); ++i) {
+    const auto rest = text.substr(i);
+    if (rest.starts_with("do()")) {
+      active = true;
+    } else if (rest.starts_with("don't()")) {
+      active = false;
+    } else if (rest.starts_with("mul(")) {
+      size_t end = 4;
+      auto digits = [&] {
+        const size_t start = end;
+        while (end < rest.size() && rest[end] >= '0' && rest[end] <= '9') {
+          ++end;
+        }
+        return end > start;
+      };
+      auto is_at = [&](char c) { return end < rest.size() && rest[end] == c; };
+      if (!digits() || !is_at(',')) {
+        continue;
+      }
+      ++end;
+      if (!digits() || !is_at(')')) {
+        continue;
+      }
+      const auto numbers = rest.substr(4, end - 4);
+      const auto product = multiply(numbers);
+      if (!product) {
+        return unexpected(std::format("mul({}) is out of range", numbers));
+      }
+      result.first += *product;
+      if (active) {
+        result.second += *product;
+      }
+    }
+  }
+  return result;
+}
+
+auto part_one_reference(const string &input) -> expected<AnswerType, string> {
+  return sum_of_part(1, scan_reference(input));
 }
 
+auto part_two_reference(const string &input) -> expected<AnswerType, string> {
+  return sum_of_part(2, scan_reference(input));
+}
+
+int main() {
+  independent_parts = true;
+  return run_day<AnswerType>(3, part_one, part_two, scan,
+                             {{1, "reference", part_one_reference},
+                              {2, "reference", part_two_reference}});
+}
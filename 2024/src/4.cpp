@@ -1,8 +1,12 @@
-#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <expected>
 #include <iostream>
-#include <sstream>
+#include <span>
+#include <string_view>
 
 #include "util.hpp"
 
@@ -12,167 +16,170 @@ using std::unexpected, std::expected;
 
 typedef int AnswerType;
 
-size_t index_from_xy(size_t grid_side_length, size_t x, size_t y);
+constexpr std::string_view XMAS = "XMAS";
+constexpr uint8_t X = 0, M = 1, A = 2, S = 3;
 
-bool search(const std::vector<char> &grid, size_t grid_side_length,
-            long startIndex, long dx, long dy);
+// Each letter in 2 bits, its index in XMAS.
+typedef PackedGrid<2> WordSearch;
 
-auto part_one(const string &input) -> expected<AnswerType, string> {
-  AnswerType result = 0;
-  size_t grid_side_length;
-
-  std::istringstream lines(input);
-  string line;
-  std::vector<char> grid;
-  while (std::getline(lines, line)) {
-    grid_side_length = line.size();
-    std::copy(line.begin(), line.end(), std::back_inserter(grid));
+auto parse_input(std::string_view input) -> expected<WordSearch, string> {
+  return WordSearch::encode(CharGrid::view(input), XMAS);
+}
+
+// Where each letter is in the rows a band reads, a row of match() masks per
+// row of the grid.
+struct LetterMasks {
+  size_t words_per_row;
+  size_t first_row;
+  std::array<std::vector<uint64_t>, XMAS.size()> letters;
+
+  std::span<const uint64_t> row(uint8_t letter, size_t y) const {
+    return {letters[letter].data() + (y - first_row) * words_per_row,
+            words_per_row};
   }
+};
+
+LetterMasks find_letters(const WordSearch &grid, const RowBand &band) {
+  LetterMasks masks{grid.words_per_row, band.read_begin, {}};
+  for (uint8_t letter = 0; letter < XMAS.size(); ++letter) {
+    auto &mask = masks.letters[letter];
+    mask.reserve((band.read_end - band.read_begin) * grid.words_per_row);
+    for (size_t y = band.read_begin; y < band.read_end; ++y) {
+      for (size_t w = 0; w < grid.words_per_row; ++w) {
+        mask.push_back(grid.match(y, w, letter));
+      }
+    }
+  }
+  return masks;
+}
 
-  for (auto const [i, c] : std::views::enumerate(grid)) {
-    for (int dx = -1; dx <= 1; ++dx) {
-      for (int dy = -1; dy <= 1; ++dy) {
+// Looks for XMAS in every direction a word of cells at a time: shifting the
+// mask of the k-th letter k cells along its row lines it up with the Xs it
+// continues, so ANDing the four leaves a bit per XMAS.
+// Rows are searched in bands on the thread pool, each reading the 3 rows
+// around it an XMAS can reach into.
+auto part_one(const WordSearch &grid) -> expected<AnswerType, string> {
+  const ptrdiff_t height = grid.height;
+  return parallel_for_rows(grid, XMAS.size() - 1, [&](const RowBand &band) {
+    const auto masks = find_letters(grid, band);
+    AnswerType result = 0;
+    for (int dy = -1; dy <= 1; ++dy) {
+      for (int dx = -1; dx <= 1; ++dx) {
         if (dx == 0 && dy == 0) {
           continue;
         }
-
-        if (search(grid, grid_side_length, i, dx, dy)) {
-          ++result;
+        for (ptrdiff_t y = band.begin; y < ptrdiff_t(band.end); ++y) {
+          const ptrdiff_t last_y = y + 3 * dy;
+          if (last_y < 0 || last_y >= height) {
+            continue;
+          }
+          for (size_t w = 0; w < grid.words_per_row; ++w) {
+            uint64_t found = ~uint64_t(0);
+            for (int k = 0; k < int(XMAS.size()); ++k) {
+              found &= WordSearch::shift_cells(masks.row(k, y + k * dy), w,
+                                               k * dx);
+            }
+            result += std::popcount(found);
+          }
         }
       }
     }
-  }
-
-  return result;
+    return result;
+  });
 }
 
-auto part_two(const string &input) -> expected<AnswerType, string> {
-  AnswerType result = 0;
-  size_t grid_side_length;
-
-  std::istringstream lines(input);
-  string line;
-  std::vector<char> grid;
-  while (std::getline(lines, line)) {
-    grid_side_length = line.size();
-    std::copy(line.begin(), line.end(), std::back_inserter(grid));
-  }
-
-  for (auto const [i, c] : std::views::enumerate(grid)) {
-    if (c != 'A') {
-      continue;
+// Both diagonals through an A need an M on one end and an S on the other.
+auto part_two(const WordSearch &grid) -> expected<AnswerType, string> {
+  return parallel_for_rows(grid, 1, [&](const RowBand &band) {
+    const auto masks = find_letters(grid, band);
+    AnswerType result = 0;
+    for (size_t y = std::max<size_t>(band.begin, 1);
+         y < band.end && y + 1 < grid.height; ++y) {
+      for (size_t w = 0; w < grid.words_per_row; ++w) {
+        const auto at = [&](uint8_t letter, size_t row, int dx) {
+          return WordSearch::shift_cells(masks.row(letter, row), w, dx);
+        };
+        const uint64_t falling = (at(M, y - 1, -1) & at(S, y + 1, 1)) |
+                                 (at(S, y - 1, -1) & at(M, y + 1, 1));
+        const uint64_t rising = (at(M, y + 1, -1) & at(S, y - 1, 1)) |
+                                (at(S, y + 1, -1) & at(M, y - 1, 1));
+        result += std::popcount(masks.row(A, y)[w] & falling & rising);
+      }
     }
+    return result;
+  });
+}
 
-    const long sx = i % grid_side_length;
-    const long sy = i / grid_side_length;
-
-    if (sx < 1 || sx >= grid_side_length - 1 || sy < 1 ||
-        sy >= grid_side_length - 1) {
-      continue;
-    }
+// The char by char searches the packed ones replaced.
+// Padded so a search from any cell in any direction stays in the buffer, the
+// border just never matches.
+auto parse_chars(std::string_view input) -> CharGrid {
+  return CharGrid(input, XMAS.size() - 1);
+}
 
-    const size_t upper_left_index =
-        index_from_xy(grid_side_length, sx - 1, sy - 1);
-    const size_t upper_right_index =
-        index_from_xy(grid_side_length, sx + 1, sy - 1);
-    const size_t bottom_right_index =
-        index_from_xy(grid_side_length, sx + 1, sy + 1);
-    const size_t bottom_left_index =
-        index_from_xy(grid_side_length, sx - 1, sy + 1);
-
-    const char upper_left = grid.at(upper_left_index);
-    const char bottom_right = grid.at(bottom_right_index);
-
-    if (!((upper_left == 'M' && bottom_right == 'S') ||
-          (upper_left == 'S' && bottom_right == 'M'))) {
-      continue;
+bool search(const CharGrid &grid, ptrdiff_t start, ptrdiff_t direction) {
+  for (size_t i = 1; i < XMAS.size(); ++i) {
+    if (grid[start + direction * ptrdiff_t(i)] != XMAS[i]) {
+      return false;
     }
+  }
+  return true;
+}
 
-    const char bottom_left = grid.at(bottom_left_index);
-    const char upper_right = grid.at(upper_right_index);
+auto part_one_reference(const CharGrid &grid) -> expected<AnswerType, string> {
+  AnswerType result = 0;
+  const auto directions = grid.neighbors8();
 
-    if (!((bottom_left == 'M' && upper_right == 'S') ||
-          (bottom_left == 'S' && upper_right == 'M'))) {
-      continue;
+  for (size_t y = 0; y < grid.height; ++y) {
+    const auto row = grid.row(y);
+    for (size_t x = 0; x < grid.width; ++x) {
+      if (row[x] != XMAS[0]) {
+        continue;
+      }
+      const ptrdiff_t start = grid.index(x, y);
+      for (const ptrdiff_t direction : directions) {
+        if (search(grid, start, direction)) {
+          ++result;
+        }
+      }
     }
-
-    ++result;
   }
 
   return result;
 }
 
-size_t index_from_xy(size_t grid_side_length, size_t x, size_t y) {
-  return x + y * grid_side_length;
+bool is_mas(char a, char b) {
+  return (a == 'M' && b == 'S') || (a == 'S' && b == 'M');
 }
 
-bool search(const std::vector<char> &grid, size_t grid_side_length,
-            long startIndex, long dx, long dy) {
-  const long sx = startIndex % grid_side_length;
-  const long sy = startIndex / grid_side_length;
-
-  constexpr char needle[5] = "XMAS";
-
-  for (int i = 0; i < (sizeof(needle) / sizeof(needle[0])) - 1; ++i) {
-    const long x = sx + dx * i;
-    const long y = sy + dy * i;
-    if (x < 0 || x >= grid_side_length || y < 0 || y >= grid_side_length) {
-      return false;
-    }
-    const size_t check_index = index_from_xy(grid_side_length, x, y);
-
-    const char c = grid.at(check_index);
-    if (c != needle[i]) {
-      return false;
+auto part_two_reference(const CharGrid &grid) -> expected<AnswerType, string> {
+  AnswerType result = 0;
+  const ptrdiff_t down_right = grid.offset(1, 1);
+  const ptrdiff_t down_left = grid.offset(-1, 1);
+
+  for (size_t y = 0; y < grid.height; ++y) {
+    const auto row = grid.row(y);
+    for (size_t x = 0; x < grid.width; ++x) {
+      if (row[x] != 'A') {
+        continue;
+      }
+      const ptrdiff_t i = grid.index(x, y);
+      if (is_mas(grid[i - down_right], grid[i + down_right]) &&
+          is_mas(grid[i - down_left], grid[i + down_left])) {
+        ++result;
+      }
     }
   }
-  return true;
+
+  return result;
 }
 
 int main() {
-  std::ostringstream buffer;
-  buffer << std::cin.rdbuf();
-  string input = buffer.str();
-
-  println(cout, " --- PART 1 LOGS ---");
-  reset_timer();
-  AnswerType part_one_result =
-      part_one(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_one_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
-
-  println(cout, " --- PART 2 LOGS ---");
-  reset_timer();
-  AnswerType part_two_result =
-      part_two(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_two_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
-
-  println(cout, "-----------------------------------------");
-  println(cout, "Day 4");
-  println(cout, "\tPart 1");
-  println(cout, "\t\tAnswer: {}", part_one_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_one_took_microseconds,
-          float(part_one_took_microseconds) / 1000.0,
-          float(part_one_took_microseconds) / 1000000.0);
-  println(cout, "\tPart 2");
-  println(cout, "\t\tAnswer: {}", part_two_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_two_took_microseconds,
-          float(part_two_took_microseconds) / 1000.0,
-          float(part_two_took_microseconds) / 1000000.0);
-  println(cout, "-----------------------------------------");
-  return 0;
+  independent_parts = true;
+  return run_day<AnswerType>(
+      4, parse_input, part_one, part_two,
+      {{1, "reference",
+        parsed_part<AnswerType>(parse_chars, part_one_reference)},
+       {2, "reference",
+        parsed_part<AnswerType>(parse_chars, part_two_reference)}});
 }
-
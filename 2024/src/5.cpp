@@ -3,7 +3,9 @@
 #include <format>
 #include <iostream>
 #include <optional>
+#include <set>
 #include <sstream>
+#include <string_view>
 #include <unordered_map>
 
 #include "util.hpp"
@@ -59,17 +61,33 @@ parse_rules(std::istringstream &lines) {
   return std::make_tuple(rules, mappings);
 }
 
-auto part_one(const string &input) -> expected<AnswerType, string> {
-  AnswerType result = 0;
+struct Manual {
+  std::vector<Rule> rules;
+  std::unordered_map<int, Rule> rulemap;
+  std::vector<std::vector<int>> updates;
+};
 
-  std::istringstream lines(input);
+auto parse_input(std::string_view input) -> Manual {
+  std::istringstream lines{string(input)};
   auto [rules, rulemap] = parse_rules(lines);
+  Manual manual{std::move(rules), std::move(rulemap)};
   string line;
-  std::vector<int> updates;
   while (std::getline(lines, line)) {
-    updates = split(line, ',', parse::to_int);
-    if (std::all_of(rules.cbegin(), rules.cend(),
-                    [&](const auto &rule) { return rule.allows(updates); })) {
+    manual.updates.push_back(split(line, ',', parse::to_int));
+  }
+  return manual;
+}
+
+bool is_sorted(const Manual &manual, const std::vector<int> &updates) {
+  return std::all_of(manual.rules.cbegin(), manual.rules.cend(),
+                     [&](const auto &rule) { return rule.allows(updates); });
+}
+
+auto part_one(const Manual &manual) -> expected<AnswerType, string> {
+  AnswerType result = 0;
+
+  for (const auto &updates : manual.updates) {
+    if (is_sorted(manual, updates)) {
       result += updates.at(updates.size() / 2);
     }
   }
@@ -77,26 +95,19 @@ auto part_one(const string &input) -> expected<AnswerType, string> {
   return result;
 }
 
-auto part_two(const string &input) -> expected<AnswerType, string> {
+auto part_two(const Manual &manual) -> expected<AnswerType, string> {
   AnswerType result = 0;
 
-  std::istringstream lines(input);
-  auto [rules, rulemap] = parse_rules(lines);
-  string line;
-  std::vector<int> updates;
-  while (std::getline(lines, line)) {
-    updates = split(line, ',', parse::to_int);
-    bool is_sorted = std::all_of(rules.cbegin(), rules.cend(), [&](auto &rule) {
-      return rule.allows(updates);
-    });
-    if (is_sorted) {
+  for (const auto &unsorted : manual.updates) {
+    if (is_sorted(manual, unsorted)) {
       continue;
     }
 
+    auto updates = unsorted;
     std::sort(updates.begin(), updates.end(),
               [&](const auto &a, const auto &b) {
                 auto key = concatenate(b, a);
-                if (!rulemap.contains(key)) {
+                if (!manual.rulemap.contains(key)) {
                   return 0;
                 }
                 return 1;
@@ -109,50 +120,66 @@ auto part_two(const string &input) -> expected<AnswerType, string> {
   return result;
 }
 
-int main() {
-  std::ostringstream buffer;
-  buffer << std::cin.rdbuf();
-  string input = buffer.str();
-
-  println(cout, " --- PART 1 LOGS ---");
-  reset_timer();
-  AnswerType part_one_result =
-      part_one(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_one_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
-
-  println(cout, " --- PART 2 LOGS ---");
-  reset_timer();
-  AnswerType part_two_result =
-      part_two(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_two_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
-
-  println(cout, "-----------------------------------------");
-  println(cout, "Day 5");
-  println(cout, "\tPart 1");
-  println(cout, "\t\tAnswer: {}", part_one_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_one_took_microseconds,
-          float(part_one_took_microseconds) / 1000.0,
-          float(part_one_took_microseconds) / 1000000.0);
-  println(cout, "\tPart 2");
-  println(cout, "\t\tAnswer: {}", part_two_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_two_took_microseconds,
-          float(part_two_took_microseconds) / 1000.0,
-          float(part_two_took_microseconds) / 1000000.0);
-  println(cout, "-----------------------------------------");
-  return 0;
+// Without Rule::allows() or the sort: an update is in order when no rule puts
+// a later page before an earlier one, and the middle page of its sorted order
+// is the one that half of the other pages have to come before.
+typedef std::set<std::pair<int, int>> RuleSet;
+
+RuleSet get_rule_set(const Manual &manual) {
+  RuleSet rules;
+  for (const auto &rule : manual.rules) {
+    rules.emplace(rule.left, rule.right);
+  }
+  return rules;
+}
+
+bool in_order(const RuleSet &rules, const std::vector<int> &updates) {
+  for (size_t i = 0; i < updates.size(); ++i) {
+    for (size_t j = i + 1; j < updates.size(); ++j) {
+      if (rules.contains({updates[j], updates[i]})) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+auto part_one_reference(const Manual &manual) -> expected<AnswerType, string> {
+  const RuleSet rules = get_rule_set(manual);
+  AnswerType result = 0;
+  for (const auto &updates : manual.updates) {
+    if (in_order(rules, updates)) {
+      result += updates[updates.size() / 2];
+    }
+  }
+  return result;
+}
+
+auto part_two_reference(const Manual &manual) -> expected<AnswerType, string> {
+  const RuleSet rules = get_rule_set(manual);
+  AnswerType result = 0;
+  for (const auto &updates : manual.updates) {
+    if (in_order(rules, updates)) {
+      continue;
+    }
+    for (const int page : updates) {
+      const auto before = std::ranges::count_if(
+          updates, [&](int other) { return rules.contains({other, page}); });
+      if (size_t(before) == updates.size() / 2) {
+        result += page;
+        break;
+      }
+    }
+  }
+  return result;
 }
 
+int main() {
+  independent_parts = true;
+  return run_day<AnswerType>(
+      5, parse_input, part_one, part_two,
+      {{1, "reference",
+        parsed_part<AnswerType>(parse_input, part_one_reference)},
+       {2, "reference",
+        parsed_part<AnswerType>(parse_input, part_two_reference)}});
+}
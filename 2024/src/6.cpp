@@ -1,8 +1,11 @@
 #include <expected>
 #include <format>
 #include <iostream>
-#include <sstream>
+#include <optional>
+#include <string_view>
+#include <tuple>
 #include <unordered_set>
+#include <vector>
 
 #include "util.hpp"
 
@@ -17,26 +20,11 @@ constexpr int DOWN = 1;
 constexpr int LEFT = 2;
 constexpr int UP = 3;
 
-struct Step {
-  int direction;
-  Point from;
-
-  bool operator==(const Step &rhs) const {
-    return direction == rhs.direction && from == rhs.from;
-  }
-};
-
-struct step_hash {
-  std::size_t operator()(const Step &v) const {
-    return std::hash<int>{}(v.direction) ^ std::hash<Point>{}(v.from);
-  }
-};
-
 // x,y,direction
-std::tuple<int, int, int>
-get_starting_position(const std::vector<std::vector<char>> &grid) {
-  for (const auto &[ty, line] : std::ranges::views::enumerate(grid)) {
-    for (const auto &[tx, c] : std::ranges::views::enumerate(line)) {
+std::optional<std::tuple<int, int, int>>
+get_starting_position(const CharGrid &grid) {
+  for (size_t y = 0; y < grid.height; ++y) {
+    for (const auto &[x, c] : std::ranges::views::enumerate(grid.row(y))) {
       int direction;
       switch (c) {
       case '>':
@@ -54,25 +42,52 @@ get_starting_position(const std::vector<std::vector<char>> &grid) {
       default:
         continue;
       }
-      return {tx, ty, direction};
+      return std::make_tuple(int(x), int(y), direction);
     }
   }
-  throw "oh no";
+  return std::nullopt;
 }
 
-// Returns the steps taken, and if it resulted in a loop or not.
-std::tuple<std::unordered_set<Step, step_hash>, bool> walk(
-    const std::vector<std::vector<char>> &grid,
-    const Point &obstacle = Point{-1, -1},
+// The cells stepped onto, with a layer per direction they were entered in.
+// What was set is remembered, so clearing costs the length of the walk rather
+// than the size of the grid.
+struct Steps {
+  BitGrid steps;
+  std::vector<std::tuple<int, int, int>> taken;
+
+  explicit Steps(const CharGrid &grid) : steps(grid, 4) {}
+
+  bool test(int x, int y, int direction) const {
+    return steps.test(x, y, direction);
+  }
+
+  void set(int x, int y, int direction) {
+    steps.set(x, y, direction);
+    taken.emplace_back(x, y, direction);
+  }
+
+  void clear() {
+    for (const auto &[x, y, direction] : taken) {
+      steps.clear(x, y, direction);
+    }
+    taken.clear();
+  }
+};
+
+// Puts the steps taken in steps, and returns if it resulted in a loop or not.
+// steps is cleared first, so one Steps can be reused for every walk without
+// allocating again.
+bool walk(
+    const CharGrid &grid, Steps &steps, const Point &obstacle = Point{-1, -1},
     std::optional<std::tuple<int, int, int>> starting_position = std::nullopt) {
+  PerfScope perf_scope("walk");
+  TraceScope trace_scope("walk");
   if (!starting_position) {
     starting_position = get_starting_position(grid);
   }
   auto [x, y, direction] = starting_position.value();
-  std::unordered_set<Step, step_hash> steps;
-  steps.insert({direction, {x, y}});
-  int width = grid.at(0).size();
-  int height = grid.size();
+  steps.clear();
+  steps.set(x, y, direction);
   while (true) {
     int next_x = x;
     int next_y = y;
@@ -91,22 +106,21 @@ std::tuple<std::unordered_set<Step, step_hash>, bool> walk(
       break;
     }
 
-    if (next_x >= 0 && next_x < width && next_y >= 0 && next_y < height) {
-      char c = grid.at(next_y).at(next_x);
+    // The grid is padded, so leaving it reads the border.
+    const char c = grid(next_x, next_y);
+    if (c != grid.border) {
       if (next_x == obstacle.x && next_y == obstacle.y) {
         direction = (direction + 1) % 4;
       } else {
-        Step step{direction, {next_x, next_y}};
-        bool duplicate = steps.contains(step);
-        if (duplicate) {
-          return std::make_tuple(steps, true);
+        if (steps.test(next_x, next_y, direction)) {
+          return true;
         }
         if (c == '#') {
           direction = (direction + 1) % 4;
         } else {
           x = next_x;
           y = next_y;
-          steps.insert(step);
+          steps.set(x, y, direction);
         }
       }
     } else {
@@ -114,7 +128,40 @@ std::tuple<std::unordered_set<Step, step_hash>, bool> walk(
     }
   }
 
-  return std::make_tuple(steps, false);
+  return false;
+}
+
+struct Lab {
+  CharGrid grid;
+  std::tuple<int, int, int> starting_point;
+};
+
+auto parse_input(std::string_view input) -> expected<Lab, string> {
+  Lab lab;
+  lab.grid = CharGrid(input);
+  const auto starting_point = get_starting_position(lab.grid);
+  if (!starting_point) {
+    return unexpected("no guard in the lab");
+  }
+  lab.starting_point = *starting_point;
+  return lab;
+}
+
+// Every point the guard visits without an extra obstruction, the candidates
+// for one in part two.
+std::vector<Point> get_route(const Lab &lab) {
+  Steps steps(lab.grid);
+  walk(lab.grid, steps, Point{-1, -1}, lab.starting_point);
+  std::vector<Point> route;
+  for (size_t y = 0; y < lab.grid.height; ++y) {
+    for (size_t x = 0; x < lab.grid.width; ++x) {
+      if (steps.test(x, y, RIGHT) || steps.test(x, y, DOWN) ||
+          steps.test(x, y, LEFT) || steps.test(x, y, UP)) {
+        route.emplace_back(x, y);
+      }
+    }
+  }
+  return route;
 }
 
 typedef std::vector<Point> Batch;
@@ -123,41 +170,12 @@ typedef AnswerType FinalResult;
 
 struct Provider {
   int batch_size;
-  std::istringstream lines;
-  std::string line_buffer;
   Batch batch_buffer;
-
-  bool prepared = false;
-  std::tuple<int, int, int> starting_point;
-  std::vector<std::vector<char>> grid;
   std::vector<Point> unique_points;
 
-  void prepare(const std::string &input) {
-    if (prepared) {
-      return;
-    }
-
-    AnswerType result = 0;
-
-    {
-      std::istringstream lines(input);
-      string line;
-      while (std::getline(lines, line)) {
-        grid.emplace_back(line.begin(), line.end());
-      }
-    }
-
-    const auto &[steps, loop] = walk(grid);
-    std::unordered_set<Point> unique_points_set;
-    for (const auto &step : steps) {
-      const auto &[it, inserted] = unique_points_set.insert(step.from);
-      if (inserted) {
-        unique_points.push_back(*it);
-      }
-    }
-
-    starting_point = get_starting_position(grid);
-    prepared = true;
+  void prepare(const Lab &lab) {
+    unique_points = get_route(lab);
+    batch_size = unique_points.size() / 2 + 1;
   }
 
   Batch provide() {
@@ -175,17 +193,16 @@ struct Provider {
 };
 
 struct Consumer {
-  std::tuple<int, int, int> starting_point;
-  std::vector<std::vector<char>> *grid;
+  const Lab *lab;
   BatchResult consume(Batch input) const {
     BatchResult result = 0;
+    Steps steps(lab->grid);
     for (const auto &p : input) {
-      auto &c = grid->at(p.y).at(p.x);
+      const char c = lab->grid(p.x, p.y);
       if (c == '^' || c == '>' || c == 'v' || c == '<') {
         continue;
       }
-      const auto &[_, loop] = walk(*grid, p, starting_point);
-      if (loop) {
+      if (walk(lab->grid, steps, p, lab->starting_point)) {
         ++result;
       }
     }
@@ -203,70 +220,88 @@ struct Solver {
   }
 };
 
-auto make_solver(int batch_size)
-    -> Multithreader<Batch, BatchResult, FinalResult> auto {
+auto make_solver(const Lab &lab)
+    -> Multithreader<Batch, BatchResult, FinalResult, Lab> auto {
   auto out = Solver{};
-  out.provider.batch_size = batch_size;
+  out.consumer.lab = &lab;
   return out;
 }
 
-auto solver = make_solver(0);
-auto part_one(const string &input) -> expected<AnswerType, string> {
-  solver.provider.prepare(input);
-  auto num_unique_points = solver.provider.unique_points.size();
-  solver.provider.batch_size = num_unique_points / 2 + 1;
-  return num_unique_points;
+auto part_one(const Lab &lab) -> expected<AnswerType, string> {
+  return get_route(lab).size();
 }
 
-auto part_two(const string &input) -> expected<AnswerType, string> {
-  solver.consumer.grid = &solver.provider.grid;
-  solver.consumer.starting_point = solver.provider.starting_point;
-  return execute<Batch, BatchResult>(input, solver, 0);
+auto part_two(const Lab &lab) -> expected<AnswerType, string> {
+  auto solver = make_solver(lab);
+  return execute<Batch, BatchResult>(lab, solver, 0);
 }
-int main() {
-  std::ostringstream buffer;
-  buffer << std::cin.rdbuf();
-  string input = buffer.str();
-
-  println(cout, " --- PART 1 LOGS ---");
-  reset_timer();
-  AnswerType part_one_result =
-      part_one(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_one_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
-
-  println(cout, " --- PART 2 LOGS ---");
-  reset_timer();
-  AnswerType part_two_result =
-      part_two(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_two_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
-
-  println(cout, "-----------------------------------------");
-  println(cout, "Day 6");
-  println(cout, "\tPart 1");
-  println(cout, "\t\tAnswer: {}", part_one_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_one_took_microseconds,
-          float(part_one_took_microseconds) / 1000.0,
-          float(part_one_took_microseconds) / 1000000.0);
-  println(cout, "\tPart 2");
-  println(cout, "\t\tAnswer: {}", part_two_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_two_took_microseconds,
-          float(part_two_took_microseconds) / 1000.0,
-          float(part_two_took_microseconds) / 1000000.0);
-  println(cout, "-----------------------------------------");
-  return 0;
+
+// The walk with a hash set of steps instead of the BitGrid, and part two one
+// candidate after another.
+struct Step {
+  int direction;
+  Point to;
+
+  bool operator==(const Step &rhs) const = default;
+};
+
+struct step_hash {
+  std::size_t operator()(const Step &step) const {
+    return std::hash<int>{}(step.direction) ^ std::hash<Point>{}(step.to);
+  }
+};
+
+// The steps taken, and whether they ended in a loop.
+std::pair<std::unordered_set<Step, step_hash>, bool>
+walk_reference(const Lab &lab, const Point &obstacle = Point{-1, -1}) {
+  auto [x, y, direction] = lab.starting_point;
+  std::unordered_set<Step, step_hash> steps{{direction, {x, y}}};
+  while (true) {
+    const auto &[dx, dy] = STEPS4[direction];
+    const Point next(x + dx, y + dy);
+    if (!lab.grid.contains(next.x, next.y)) {
+      return {std::move(steps), false};
+    }
+    if (next == obstacle || lab.grid(next.x, next.y) == '#') {
+      direction = (direction + 1) % 4;
+    } else if (!steps.insert({direction, next}).second) {
+      return {std::move(steps), true};
+    } else {
+      x = next.x;
+      y = next.y;
+    }
+  }
+}
+
+std::unordered_set<Point> get_route_reference(const Lab &lab) {
+  std::unordered_set<Point> route;
+  for (const auto &step : walk_reference(lab).first) {
+    route.insert(step.to);
+  }
+  return route;
 }
 
+auto part_one_reference(const Lab &lab) -> expected<AnswerType, string> {
+  return get_route_reference(lab).size();
+}
+
+auto part_two_reference(const Lab &lab) -> expected<AnswerType, string> {
+  const auto [x, y, direction] = lab.starting_point;
+  AnswerType result = 0;
+  for (const auto &candidate : get_route_reference(lab)) {
+    if (candidate != Point(x, y) && walk_reference(lab, candidate).second) {
+      ++result;
+    }
+  }
+  return result;
+}
+
+int main() {
+  independent_parts = true;
+  return run_day<AnswerType>(
+      6, parse_input, part_one, part_two,
+      {{1, "reference",
+        parsed_part<AnswerType>(parse_input, part_one_reference)},
+       {2, "reference",
+        parsed_part<AnswerType>(parse_input, part_two_reference)}});
+}
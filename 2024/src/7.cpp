@@ -7,6 +7,7 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <utility>
 
 #include "util.hpp"
 
@@ -50,7 +51,14 @@ bool can_reach(const std::vector<char> &operators, const Equation &e) {
         nextValue *= e.parts[index];
         break;
       case '|':
-        nextValue = concatenate(nextValue, e.parts[index]);
+        // Past 2^64 is past any target, unless a later part of 0 multiplies
+        // it back down, which puzzle inputs don't have.
+        if (const auto concatenated =
+                checked_concatenate(nextValue, e.parts[index])) {
+          nextValue = *concatenated;
+        } else {
+          continue;
+        }
         break;
       }
 
@@ -65,9 +73,60 @@ bool can_reach(const std::vector<char> &operators, const Equation &e) {
   return backtrack(1, e.parts[0]);
 }
 
+// Same as can_reach, but works backwards from the target. The last part can
+// only have been added if it's not larger than the target, multiplied if it
+// divides the target and concatenated if the target ends with its digits,
+// which prunes most of the tree before it is expanded.
+bool can_reach_reverse(const std::vector<char> &operators, const Equation &e) {
+  std::function<bool(int, AnswerType)> backtrack = [&](int index,
+                                                       AnswerType target) {
+    const AnswerType part = e.parts[index];
+    if (index == 0) {
+      return target == part;
+    }
+
+    for (char op : operators) {
+      switch (op) {
+      case '+':
+        if (target >= part && backtrack(index - 1, target - part)) {
+          return true;
+        }
+        break;
+      case '*':
+        if (part == 0) {
+          if (target == 0) {
+            return true;
+          }
+        } else if (target % part == 0 && backtrack(index - 1, target / part)) {
+          return true;
+        }
+        break;
+      case '|': {
+        // Matches concatenate(), which leaves x as is when y is 0.
+        const AnswerType pow10 = pow10_above(part);
+        if (target % pow10 == part && backtrack(index - 1, target / pow10)) {
+          return true;
+        }
+        break;
+      }
+      }
+    }
+
+    return false;
+  };
+
+  return backtrack(e.parts.size() - 1, e.target);
+}
+
+typedef bool (*ReachFunction)(const std::vector<char> &, const Equation &);
+
+const std::vector<char> WITHOUT_CONCATENATION = {'+', '*'};
+const std::vector<char> WITH_CONCATENATION = {'+', '*', '|'};
+
 typedef std::vector<string> Batch;
-typedef AnswerType BatchResult;
-typedef AnswerType FinalResult;
+// The calibration results with and without concatenation.
+typedef std::pair<AnswerType, AnswerType> BatchResult;
+typedef BatchResult FinalResult;
 
 struct Provider {
   int batch_size;
@@ -88,13 +147,19 @@ struct Provider {
 };
 
 struct Consumer {
-  std::vector<char> operators;
+  ReachFunction reach;
+  bool without_concatenation, with_concatenation;
   BatchResult consume(Batch input) const {
-    BatchResult result = 0;
+    BatchResult result{0, 0};
     for (const auto &line : input) {
       const Equation equation = parse_line(line);
-      if (can_reach(operators, equation)) {
-        result += equation.target;
+      // Whatever can be reached without concatenation can be reached with
+      // it, so the larger tree is only searched when the smaller one fails.
+      if (without_concatenation && reach(WITHOUT_CONCATENATION, equation)) {
+        result.first += equation.target;
+        result.second += equation.target;
+      } else if (with_concatenation && reach(WITH_CONCATENATION, equation)) {
+        result.second += equation.target;
       }
     }
     return result;
@@ -106,73 +171,53 @@ struct Solver {
   Consumer consumer;
 
   FinalResult combine(FinalResult accumulator, BatchResult value) const {
-    return accumulator + value;
+    return {accumulator.first + value.first, accumulator.second + value.second};
   }
 };
 
-auto make_solver(int batch_size, std::vector<char> operators)
+auto make_solver(int batch_size, ReachFunction reach,
+                 bool without_concatenation, bool with_concatenation)
     -> Multithreader<Batch, BatchResult, FinalResult> auto {
   auto out = Solver{};
   out.provider.batch_size = batch_size;
-  out.consumer.operators = operators;
+  out.consumer.reach = reach;
+  out.consumer.without_concatenation = without_concatenation;
+  out.consumer.with_concatenation = with_concatenation;
   return out;
 }
 
+FinalResult solve(const std::string &input, ReachFunction reach,
+                  bool without_concatenation, bool with_concatenation) {
+  auto solver_instance = make_solver(425, reach, without_concatenation,
+                                     with_concatenation);
+  return execute<Batch, BatchResult, FinalResult>(input, solver_instance,
+                                                  {0, 0});
+}
+
 auto part_one(const std::string &input) -> expected<AnswerType, string> {
-  std::vector<char> operators{'+', '*'};
-  auto solver_instance = make_solver(425, operators);
-  AnswerType result =
-      execute<Batch, BatchResult, AnswerType>(input, solver_instance, 0);
-  return result;
+  return solve(input, can_reach_reverse, true, false).first;
 }
 
 auto part_two(const string &input) -> expected<AnswerType, string> {
-  std::vector<char> operators{'+', '*', '|'};
-  auto solver_instance = make_solver(425, operators);
-  AnswerType result =
-      execute<Batch, BatchResult, AnswerType>(input, solver_instance, 0);
-  return result;
+  return solve(input, can_reach_reverse, false, true).second;
+}
+
+auto solve_both(const string &input) -> expected<FinalResult, string> {
+  return solve(input, can_reach_reverse, true, true);
+}
+
+auto part_one_reference(const std::string &input)
+    -> expected<AnswerType, string> {
+  return solve(input, can_reach, true, false).first;
+}
+
+auto part_two_reference(const string &input) -> expected<AnswerType, string> {
+  return solve(input, can_reach, false, true).second;
 }
 
 int main() {
-  std::ostringstream buffer;
-  buffer << std::cin.rdbuf();
-  string input = buffer.str();
-
-  println(cout, " --- PART 1 LOGS ---");
-  reset_timer();
-  AnswerType part_one_result =
-      part_one(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_one_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
-
-  println(cout, " --- PART 2 LOGS ---");
-  reset_timer();
-  AnswerType part_two_result =
-      part_two(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_two_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
-
-  println(cout, "-----------------------------------------");
-  println(cout, "Day 7");
-  println(cout, "\tPart 1");
-  println(cout, "\t\tAnswer: {}", part_one_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_one_took_microseconds, float(part_one_took_microseconds)/1000.0, float(part_one_took_microseconds) / 1000000.0);
-  println(cout, "\tPart 2");
-  println(cout, "\t\tAnswer: {}", part_two_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_two_took_microseconds, float(part_two_took_microseconds)/1000.0, float(part_two_took_microseconds) / 1000000.0);
-  println(cout, "-----------------------------------------");
-  return 0;
+  independent_parts = true;
+  return run_day<AnswerType>(7, part_one, part_two, solve_both,
+                             {{1, "reference", part_one_reference},
+                              {2, "reference", part_two_reference}});
 }
@@ -1,14 +1,17 @@
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
 #include <expected>
 #include <format>
 #include <iostream>
+#include <iterator>
 #include <numeric>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "thirdpartyutils.hpp"
 #include "util.hpp"
@@ -19,51 +22,61 @@ using std::unexpected, std::expected;
 
 typedef uint64_t AnswerType;
 
-typedef std::vector<Point> Batch;
-typedef std::unordered_set<Point> BatchResult;
-typedef std::unordered_set<Point> FinalResult;
-
-struct Provider {
-  std::string line_buffer;
-  Batch batch_buffer;
-
+struct City {
   std::unordered_map<char, std::vector<Point>> antennas;
-  std::unordered_map<char, std::vector<Point>> cached_antennas;
-  int width, height;
+  int width = 0, height = 0;
+};
 
-  void prepare(const std::string &input) {
-    if (cached_antennas.size()) {
-      this->antennas = cached_antennas;
-      return;
-    }
-    std::istringstream lines(input);
-    int y = 0;
-    while (std::getline(lines, line_buffer)) {
-      int x = 0;
-      for (const char c : line_buffer) {
-        if (c != '.') {
-          if (!cached_antennas.contains(c)) {
-            cached_antennas.insert_or_assign(c, std::vector<Point>{});
-          }
-          cached_antennas.at(c).push_back({x, y});
-        }
-        ++x;
+typedef distinct_pairs_range<std::vector<Point>::const_iterator> AntennaPairs;
+// A run of the pairs of antennas of one frequency.
+typedef std::pair<AntennaPairs::iterator, AntennaPairs::iterator> Batch;
+// The antinodes found.
+typedef BitGrid BatchResult;
+typedef BitGrid FinalResult;
+
+auto parse_input(std::string_view input) -> City {
+  City city;
+  for (const auto line : split_lines(input)) {
+    int x = 0;
+    for (const char c : line) {
+      if (c != '.') {
+        city.antennas[c].push_back({x, city.height});
       }
-      width = x;
-      ++y;
+      ++x;
+    }
+    city.width = x;
+    ++city.height;
+  }
+  return city;
+}
+
+// Fewer pairs than this aren't worth a batch of their own, since every batch
+// costs a BitGrid of the city to combine.
+constexpr int64_t MIN_PAIRS_PER_BATCH = 1024;
+
+// A batch per frequency, except that frequencies with many antennas have
+// their pairs split between batches so they are not left to one thread.
+struct Provider {
+  std::vector<Batch> batches;
+
+  void prepare(const City &city) {
+    batches.clear();
+    const int64_t max_parts = 4 * thread_pool().workers.size();
+    for (const auto &[frequency, antennas] : city.antennas) {
+      const auto pairs = cdistinct_pairs(antennas);
+      const int64_t parts =
+          std::clamp<int64_t>(pairs.size() / MIN_PAIRS_PER_BATCH, 1, max_parts);
+      std::ranges::move(pairs.split(parts), std::back_inserter(batches));
     }
-    height = y;
-    this->antennas = cached_antennas;
   }
 
   Batch provide() {
-    const auto &entry = antennas.begin();
-    Batch batch = entry->second;
-    antennas.erase(entry->first);
+    Batch batch = batches.back();
+    batches.pop_back();
     return batch;
   }
 
-  bool done() const { return antennas.size() <= 0; }
+  bool done() const { return batches.empty(); }
 };
 
 struct Consumer {
@@ -76,26 +89,26 @@ struct Consumer {
       Point b(line.b.x - step_size.x, line.b.y - step_size.y);
 
       if (a.x >= 0 && a.x < width && a.y >= 0 && a.y < height) {
-        result.insert(a);
+        result.set(a.x, a.y);
       }
       if (b.x >= 0 && b.x < width && b.y >= 0 && b.y < height) {
-        result.insert(b);
+        result.set(b.x, b.y);
       }
     } else if (part == 2) {
-      result.insert(line.a);
+      result.set(line.a.x, line.a.y);
       // Since we are covering the entire line anyways, just start from line.a
       Point a(line.a.x + step_size.x, line.a.y + step_size.y);
       Point b(line.a.x - step_size.x, line.a.y - step_size.y);
       while (true) {
         bool one_good = false;
         if (a.x >= 0 && a.x < width && a.y >= 0 && a.y < height) {
-          result.insert(a);
+          result.set(a.x, a.y);
           a.x += step_size.x;
           a.y += step_size.y;
           one_good = true;
         }
         if (b.x >= 0 && b.x < width && b.y >= 0 && b.y < height) {
-          result.insert(b);
+          result.set(b.x, b.y);
           b.x -= step_size.x;
           b.y -= step_size.y;
           one_good = true;
@@ -109,8 +122,9 @@ struct Consumer {
   }
 
   BatchResult consume(Batch input) const {
-    BatchResult unique_locations;
-    for (const auto &pair : cdistinct_pairs(input)) {
+    BatchResult unique_locations(width, height);
+    for (auto it = input.first; it != input.second; ++it) {
+      const auto pair = *it;
       Point a = pair.first;
       Point b = pair.second;
       Point step_size(a.x - b.x, a.y - b.y);
@@ -137,79 +151,81 @@ struct Solver {
   Provider provider;
   Consumer consumer;
 
-  FinalResult combine(FinalResult accumulator, BatchResult value) const {
-    accumulator.insert(value.begin(), value.end());
+  FinalResult combine(FinalResult accumulator, const BatchResult &value) const {
+    accumulator |= value;
     return accumulator;
   }
 };
 
-auto make_solver() -> Multithreader<Batch, BatchResult, FinalResult> auto {
+auto make_solver(const City &city, int part)
+    -> Multithreader<Batch, BatchResult, FinalResult, City> auto {
   auto out = Solver{};
+  out.consumer.part = part;
+  out.consumer.width = city.width;
+  out.consumer.height = city.height;
   return out;
 }
 
-auto solver = make_solver();
+auto part_one(const City &city) -> expected<AnswerType, string> {
+  auto solver = make_solver(city, 1);
+  AnswerType result = execute<Batch, BatchResult, FinalResult>(
+                          city, solver, BitGrid(city.width, city.height))
+                          .count();
+  return result;
+}
 
-auto part_one(const std::string &input) -> expected<AnswerType, string> {
-  solver.provider.prepare(input);
-  solver.consumer.part = 1;
-  solver.consumer.width = solver.provider.width;
-  solver.consumer.height = solver.provider.height;
-  AnswerType result =
-      execute<Batch, BatchResult, FinalResult>(input, solver, {}).size();
+auto part_two(const City &city) -> expected<AnswerType, string> {
+  auto solver = make_solver(city, 2);
+  AnswerType result = execute<Batch, BatchResult, FinalResult>(
+                          city, solver, BitGrid(city.width, city.height))
+                          .count();
   return result;
 }
 
-auto part_two(const string &input) -> expected<AnswerType, string> {
-  solver.consumer.part = 2;
-  AnswerType result =
-      execute<Batch, BatchResult, FinalResult>(input, solver, {}).size();
+// Without batches, the BitGrid or stepping along the lines: part one collects
+// the antinodes in a hash set, part two checks every cell against every pair
+// of antennas.
+auto part_one_reference(const City &city) -> expected<AnswerType, string> {
+  std::unordered_set<Point> antinodes;
+  for (const auto &[frequency, antennas] : city.antennas) {
+    for (const auto &a : antennas) {
+      for (const auto &b : antennas) {
+        const Point antinode(2 * a.x - b.x, 2 * a.y - b.y);
+        if (a != b && antinode.x >= 0 && antinode.x < city.width &&
+            antinode.y >= 0 && antinode.y < city.height) {
+          antinodes.insert(antinode);
+        }
+      }
+    }
+  }
+  return antinodes.size();
+}
+
+auto part_two_reference(const City &city) -> expected<AnswerType, string> {
+  AnswerType result = 0;
+  for (int y = 0; y < city.height; ++y) {
+    for (int x = 0; x < city.width; ++x) {
+      bool in_line = false;
+      for (const auto &[frequency, antennas] : city.antennas) {
+        for (size_t i = 0; i < antennas.size() && !in_line; ++i) {
+          for (size_t j = i + 1; j < antennas.size() && !in_line; ++j) {
+            const Point &a = antennas[i], &b = antennas[j];
+            in_line = (b.x - a.x) * (y - a.y) == (b.y - a.y) * (x - a.x);
+          }
+        }
+      }
+      result += in_line;
+    }
+  }
   return result;
 }
 
 int main() {
-  std::ostringstream buffer;
-  buffer << std::cin.rdbuf();
-  string input = buffer.str();
-
-  println(cout, " --- PART 1 LOGS ---");
-  reset_timer();
-  AnswerType part_one_result =
-      part_one(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_one_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
-
-  println(cout, " --- PART 2 LOGS ---");
-  reset_timer();
-  AnswerType part_two_result =
-      part_two(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_two_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
-
-  println(cout, "-----------------------------------------");
-  println(cout, "Day 8");
-  println(cout, "\tPart 1");
-  println(cout, "\t\tAnswer: {}", part_one_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_one_took_microseconds,
-          float(part_one_took_microseconds) / 1000.0,
-          float(part_one_took_microseconds) / 1000000.0);
-  println(cout, "\tPart 2");
-  println(cout, "\t\tAnswer: {}", part_two_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_two_took_microseconds,
-          float(part_two_took_microseconds) / 1000.0,
-          float(part_two_took_microseconds) / 1000000.0);
-  println(cout, "-----------------------------------------");
-  return 0;
+  independent_parts = true;
+  return run_day<AnswerType>(
+      8, parse_input, part_one, part_two,
+      {{1, "reference",
+        parsed_part<AnswerType>(parse_input, part_one_reference)},
+       {2, "reference",
+        parsed_part<AnswerType>(parse_input, part_two_reference)}});
 }
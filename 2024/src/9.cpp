@@ -6,8 +6,9 @@
 #include <format>
 #include <iostream>
 #include <iterator>
-#include <sstream>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 
 #include "util.hpp"
 
@@ -36,7 +37,7 @@ void print_disk(const Disk &disk) {
   println(cout);
 }
 
-Disk parse_input(const std::string &input) {
+Disk parse_input(std::string_view input) {
   Disk disk;
   for (int i = 0; i < input.size(); ++i) {
     char c = input[i];
@@ -90,6 +91,7 @@ bool is_packed(Disk &disk) {
 }
 
 void pack(Disk &disk) {
+  TraceScope scope("pack");
   while (!is_packed(disk)) {
     Block *empty = get_first_empty_block(disk);
     if (empty == nullptr) {
@@ -119,13 +121,16 @@ AnswerType checksum(const Disk &disk) {
   return sum;
 }
 
-auto part_one(const std::string &input) -> expected<AnswerType, string> {
-  Disk disk = parse_input(input);
+// The parts pack a copy, the parsed disk is shared.
+auto part_one(const Disk &parsed) -> expected<AnswerType, string> {
+  Disk disk = parsed;
   pack(disk);
   return checksum(disk);
 }
 
-std::tuple<std::vector<Block *>, long> get_file(Disk &disk, int file_id) {
+// The blocks come from scratch_resource().
+std::tuple<std::pmr::vector<Block *>, long> get_file(Disk &disk,
+                                                     int file_id) {
   auto first = std::find_if(disk.begin(), disk.end(), [=](const Block &block) {
     return !block.free && block.file_id == file_id;
   });
@@ -134,40 +139,16 @@ std::tuple<std::vector<Block *>, long> get_file(Disk &disk, int file_id) {
     return !block.free && block.file_id == file_id;
   });
 
-  std::vector<Block *> result;
+  std::pmr::vector<Block *> result(scratch_resource());
   for (auto it = first; it != last; ++it) {
     result.push_back(&(*it));
   }
-  return std::make_tuple(result, start_index);
-}
-
-std::tuple<std::vector<Block *>, long>
-get_first_contiguous_block_of_size(Disk &disk, long end_index, size_t size) {
-  auto start = disk.begin();
-  const auto end = start + end_index;
-  while (start < end) {
-    std::vector<Block *> result;
-    auto it =
-        std::find_if(start, end, [](const Block &block) { return block.free; });
-    if (it >= end) {
-      return {};
-    }
-
-    result.push_back(&(*it));
-    while (++it < end && (*it).free) {
-      result.push_back(&(*it));
-    }
-
-    if (result.size() >= size) {
-      return std::make_tuple(result, std::distance(disk.begin(), start));
-    }
-
-    start = it;
-  }
-  return {};
+  return std::make_tuple(std::move(result), start_index);
 }
 
 void block_pack(Disk &disk) {
+  TraceScope scope("block_pack");
+  ScratchScope scratch;
   std::vector<std::pair<int, int>> free_spans;
   auto start = disk.begin();
   const auto end = disk.end();
@@ -219,55 +200,93 @@ void block_pack(Disk &disk) {
   } while (--current_file_id >= 0);
 }
 
-auto part_two(const string &input) -> expected<AnswerType, string> {
-  Disk disk = parse_input(input);
+auto part_two(const Disk &parsed) -> expected<AnswerType, string> {
+  Disk disk = parsed;
   block_pack(disk);
   return checksum(disk);
 }
 
-int main() {
-  std::ostringstream buffer;
-  buffer << std::cin.rdbuf();
-  string input = buffer.str();
+// The packing without the block scans: part one moves the last file block into
+// the first free one from both ends at once, part two moves whole files
+// between spans of the disk.
+auto part_one_reference(const Disk &parsed) -> expected<AnswerType, string> {
+  Disk disk = parsed;
+  if (disk.empty()) {
+    return 0;
+  }
+  size_t first = 0, last = disk.size() - 1;
+  while (true) {
+    while (first < last && !disk[first].free) {
+      ++first;
+    }
+    while (first < last && disk[last].free) {
+      --last;
+    }
+    if (first >= last) {
+      break;
+    }
+    std::swap(disk[first], disk[last]);
+  }
+  return checksum(disk);
+}
 
-  println(cout, " --- PART 1 LOGS ---");
-  reset_timer();
-  AnswerType part_one_result =
-      part_one(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_one_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
+struct Span {
+  size_t start, size;
+};
 
-  println(cout, " --- PART 2 LOGS ---");
-  reset_timer();
-  AnswerType part_two_result =
-      part_two(input)
-          .or_else([](string error) {
-            println(cout, "\033[1;31m{}\033[0m", error);
-            return expected<AnswerType, string>(0);
-          })
-          .value();
-  auto part_two_took_microseconds = get_timer_microseconds();
-  println(cout);
-  println(cout);
+auto part_two_reference(const Disk &disk) -> expected<AnswerType, string> {
+  // The files by id, and the free spans in disk order.
+  std::vector<std::pair<int, Span>> files;
+  std::vector<Span> free_spans;
+  for (size_t i = 0; i < disk.size();) {
+    size_t end = i;
+    while (end < disk.size() && disk[end].free == disk[i].free &&
+           disk[end].file_id == disk[i].file_id) {
+      ++end;
+    }
+    if (disk[i].free) {
+      // Files of size 0 leave neighboring free runs with different ids.
+      if (!free_spans.empty() &&
+          free_spans.back().start + free_spans.back().size == i) {
+        free_spans.back().size += end - i;
+      } else {
+        free_spans.push_back({i, end - i});
+      }
+    } else {
+      files.emplace_back(disk[i].file_id, Span{i, end - i});
+    }
+    i = end;
+  }
 
-  println(cout, "-----------------------------------------");
-  println(cout, "Day 9");
-  println(cout, "\tPart 1");
-  println(cout, "\t\tAnswer: {}", part_one_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_one_took_microseconds,
-          float(part_one_took_microseconds) / 1000.0,
-          float(part_one_took_microseconds) / 1000000.0);
-  println(cout, "\tPart 2");
-  println(cout, "\t\tAnswer: {}", part_two_result);
-  println(cout, "\t\tTook {} us ({} ms) ({} s)", part_two_took_microseconds,
-          float(part_two_took_microseconds) / 1000.0,
-          float(part_two_took_microseconds) / 1000000.0);
-  println(cout, "-----------------------------------------");
-  return 0;
+  for (auto &[file_id, file] : std::views::reverse(files)) {
+    for (auto &span : free_spans) {
+      if (span.start >= file.start) {
+        break;
+      }
+      if (span.size >= file.size) {
+        file.start = span.start;
+        span.start += file.size;
+        span.size -= file.size;
+        break;
+      }
+    }
+  }
+
+  AnswerType result = 0;
+  for (const auto &[file_id, file] : files) {
+    for (size_t i = file.start; i < file.start + file.size; ++i) {
+      result += i * file_id;
+    }
+  }
+  return result;
+}
+
+int main() {
+  independent_parts = true;
+  return run_day<AnswerType>(
+      9, parse_input, part_one, part_two,
+      {{1, "reference",
+        parsed_part<AnswerType>(parse_input, part_one_reference)},
+       {2, "reference",
+        parsed_part<AnswerType>(parse_input, part_two_reference)}});
 }
@@ -0,0 +1,209 @@
+#pragma once
+#ifndef ALLOC_HPP
+#define ALLOC_HPP
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include <malloc.h>
+#include <sys/resource.h>
+
+// Heap accounting through replaced global operator new/delete, compiled in
+// only when building with -DAOC_ALLOC. Every day is a single translation
+// unit, which is what allows the replacements to live in a header.
+#ifdef AOC_ALLOC
+constexpr bool alloc_enabled = true;
+#else
+constexpr bool alloc_enabled = false;
+#endif
+
+struct AllocStats {
+  std::atomic<uint64_t> allocations{0}, bytes{0};
+  std::atomic<int64_t> live{0}, peak_live{0};
+
+  void record_alloc(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(size, std::memory_order_relaxed);
+    int64_t now = live.fetch_add(size, std::memory_order_relaxed) + size;
+    int64_t peak = peak_live.load(std::memory_order_relaxed);
+    while (now > peak && !peak_live.compare_exchange_weak(
+                             peak, now, std::memory_order_relaxed)) {
+    }
+  }
+
+  void record_free(size_t size) {
+    live.fetch_sub(size, std::memory_order_relaxed);
+  }
+
+  // Starts a new measurement window. Live bytes carry over for the process
+  // total, but start at 0 per thread since other threads may free what a
+  // thread allocated.
+  void reset(bool keep_live) {
+    allocations = 0;
+    bytes = 0;
+    if (!keep_live) {
+      live = 0;
+    }
+    peak_live = live.load();
+  }
+};
+
+struct AllocSample {
+  int thread = -1;
+  uint64_t allocations = 0, bytes = 0;
+  int64_t peak_live = 0;
+};
+
+struct AllocReport {
+  AllocSample total;
+  std::vector<AllocSample> threads;
+  // Process-wide high-water mark from getrusage, so it never goes down.
+  long peak_rss_kib = 0;
+};
+
+// Threads past the last slot all share it.
+constexpr int MAX_ALLOC_THREADS = 256;
+inline AllocStats alloc_total;
+inline AllocStats alloc_threads[MAX_ALLOC_THREADS];
+inline std::atomic<int> alloc_num_threads{0};
+
+inline AllocStats &alloc_thread_stats() {
+  thread_local int slot = -1;
+  if (slot < 0) {
+    slot = std::min(alloc_num_threads.fetch_add(1), MAX_ALLOC_THREADS - 1);
+  }
+  return alloc_threads[slot];
+}
+
+inline void record_alloc(void *ptr) {
+  size_t size = malloc_usable_size(ptr);
+  alloc_total.record_alloc(size);
+  alloc_thread_stats().record_alloc(size);
+}
+
+inline void record_free(void *ptr) {
+  size_t size = malloc_usable_size(ptr);
+  alloc_total.record_free(size);
+  alloc_thread_stats().record_free(size);
+}
+
+inline void reset_alloc_stats() {
+  alloc_total.reset(true);
+  for (auto &stats : alloc_threads) {
+    stats.reset(false);
+  }
+}
+
+inline AllocReport take_alloc_report() {
+  AllocReport report;
+  report.total = {-1, alloc_total.allocations, alloc_total.bytes,
+                  alloc_total.peak_live};
+  int num_threads = std::min(alloc_num_threads.load(), MAX_ALLOC_THREADS);
+  for (int i = 0; i < num_threads; ++i) {
+    const auto &stats = alloc_threads[i];
+    if (stats.allocations > 0) {
+      report.threads.push_back(
+          {i, stats.allocations, stats.bytes, stats.peak_live});
+    }
+  }
+  rusage usage{};
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    report.peak_rss_kib = usage.ru_maxrss;
+  }
+  return report;
+}
+
+#ifdef AOC_ALLOC
+inline void *counted_alloc(std::size_t size, std::size_t alignment) {
+  size = size ? size : 1;
+  // aligned_alloc wants the size to be a multiple of the alignment.
+  void *ptr = alignment <= alignof(std::max_align_t)
+                  ? std::malloc(size)
+                  : std::aligned_alloc(alignment, (size + alignment - 1) &
+                                                      ~(alignment - 1));
+  if (ptr) {
+    record_alloc(ptr);
+  }
+  return ptr;
+}
+
+inline void counted_free(void *ptr) {
+  if (ptr) {
+    record_free(ptr);
+    std::free(ptr);
+  }
+}
+
+void *operator new(std::size_t size) {
+  if (void *ptr = counted_alloc(size, 0)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  if (void *ptr = counted_alloc(size, std::size_t(alignment))) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return counted_alloc(size, 0);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment,
+                   const std::nothrow_t &) noexcept {
+  return counted_alloc(size, std::size_t(alignment));
+}
+
+void *operator new[](std::size_t size) { return ::operator new(size); }
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+  return ::operator new(size, alignment);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return counted_alloc(size, 0);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment,
+                     const std::nothrow_t &) noexcept {
+  return counted_alloc(size, std::size_t(alignment));
+}
+
+void operator delete(void *ptr) noexcept { counted_free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { counted_free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept {
+  counted_free(ptr);
+}
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+  counted_free(ptr);
+}
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+  counted_free(ptr);
+}
+void operator delete(void *ptr, std::align_val_t,
+                     const std::nothrow_t &) noexcept {
+  counted_free(ptr);
+}
+void operator delete[](void *ptr) noexcept { counted_free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { counted_free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+  counted_free(ptr);
+}
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept {
+  counted_free(ptr);
+}
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+  counted_free(ptr);
+}
+void operator delete[](void *ptr, std::align_val_t,
+                       const std::nothrow_t &) noexcept {
+  counted_free(ptr);
+}
+#endif
+#endif // ALLOC_HPP
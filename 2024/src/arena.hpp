@@ -0,0 +1,106 @@
+#pragma once
+#ifndef ARENA_HPP
+#define ARENA_HPP
+// Scratch memory for solvers, through std::pmr. Containers built on
+// scratch_resource() allocate from a per-thread pool on top of a bump arena,
+// and everything they allocated is released at once when the outermost
+// ScratchScope on the thread ends. The arena keeps its chunks for the next
+// scope, so once a thread has warmed up its scratch memory costs no malloc.
+//
+// What is allocated from it has to be gone by the end of the scope, and can't
+// be freed on another thread. Copying a std::pmr container out gives the copy
+// the default resource, moving it keeps the arena.
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+// Bump allocation over chunks that are kept on reset(). Freeing does nothing.
+struct Arena : std::pmr::memory_resource {
+  static constexpr size_t FIRST_CHUNK_SIZE = 64 * 1024;
+
+  struct Chunk {
+    std::unique_ptr<std::byte[]> memory;
+    size_t size;
+  };
+  std::vector<Chunk> chunks;
+  // The chunk being bumped and how much of it is used.
+  size_t current = 0;
+  size_t offset = 0;
+
+  void reset() {
+    current = 0;
+    offset = 0;
+  }
+
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    for (;; ++current, offset = 0) {
+      if (current == chunks.size()) {
+        const size_t size = std::max(
+            chunks.empty() ? FIRST_CHUNK_SIZE : chunks.back().size * 2,
+            bytes + alignment);
+        chunks.push_back(
+            {std::make_unique_for_overwrite<std::byte[]>(size), size});
+      }
+      auto &chunk = chunks[current];
+      void *p = chunk.memory.get() + offset;
+      size_t space = chunk.size - offset;
+      if (std::align(alignment, bytes, p, space)) {
+        offset = chunk.size - space + bytes;
+        return p;
+      }
+    }
+  }
+
+  void do_deallocate(void *, size_t, size_t) override {}
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override {
+    return this == &other;
+  }
+};
+
+struct Scratch {
+  Arena arena;
+  // Reuses what is freed within a scope, which the arena alone can't.
+  std::pmr::unsynchronized_pool_resource pool{&arena};
+  int depth = 0;
+};
+
+// The thread_local is only a pointer: glibc won't dlclose() an object while a
+// thread_local with a destructor is pending on a live thread, which would keep
+// every day host.cpp loaded, its thread pool with it. The Scratches are freed
+// with the other statics instead, at exit or unload.
+inline Scratch &thread_scratch() {
+  thread_local Scratch *scratch = nullptr;
+  if (!scratch) {
+    static std::mutex mutex;
+    static std::vector<std::unique_ptr<Scratch>> scratches;
+    std::lock_guard lock(mutex);
+    scratch = scratches.emplace_back(std::make_unique<Scratch>()).get();
+  }
+  return *scratch;
+}
+
+inline std::pmr::memory_resource *scratch_resource() {
+  return &thread_scratch().pool;
+}
+
+// Scopes nest, so a solver can open one without knowing whether execute() or
+// another part of it already has.
+struct ScratchScope {
+  ScratchScope() { ++thread_scratch().depth; }
+  ScratchScope(const ScratchScope &) = delete;
+  ScratchScope &operator=(const ScratchScope &) = delete;
+
+  ~ScratchScope() {
+    auto &scratch = thread_scratch();
+    if (--scratch.depth == 0) {
+      scratch.pool.release();
+      scratch.arena.reset();
+    }
+  }
+};
+#endif // ARENA_HPP
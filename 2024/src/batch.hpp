@@ -0,0 +1,246 @@
+#pragma once
+#ifndef BATCH_HPP
+#define BATCH_HPP
+// Framed input streams for batch mode, where one process solves many inputs
+// so the thread pool and the allocator stay warm between them.
+//
+// Each input is sent as a header line followed by exactly LENGTH bytes:
+//
+//   LENGTH PART [NAME]\n<input>
+//
+// PART is 1, 2 or both. For each part solved one line is written back:
+//
+//   NAME\tPART\tANSWER\tMICROSECONDS
+//
+// Days with parse_input() first write a line with PART "parse" and ANSWER "ok"
+// or the error. Days with solve_both() solve PART both in one pass and report
+// its time on both lines. Days with independent_parts solve them at the same
+// time.
+//
+// A stream is either stdin/stdout or a connection to a Unix socket. Inputs
+// that are files can instead be listed by path, see serve_files().
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "reader.hpp"
+
+struct Frame {
+  std::string name;
+  std::string part;
+  // Reused between frames so steady state batches don't allocate for it.
+  std::string input;
+};
+
+// Buffered reads from a file descriptor.
+struct FrameReader {
+  int fd;
+  std::vector<char> buffer = std::vector<char>(1 << 16);
+  size_t begin = 0, end = 0;
+  std::string header;
+
+  explicit FrameReader(int fd) : fd(fd) {}
+
+  bool fill() {
+    begin = 0;
+    ssize_t n;
+    do {
+      n = ::read(fd, buffer.data(), buffer.size());
+    } while (n < 0 && errno == EINTR);
+    end = n > 0 ? size_t(n) : 0;
+    return end > 0;
+  }
+
+  bool read_line(std::string &line) {
+    line.clear();
+    while (true) {
+      if (begin == end && !fill()) {
+        return !line.empty();
+      }
+      const char *start = buffer.data() + begin;
+      const char *newline =
+          static_cast<const char *>(std::memchr(start, '\n', end - begin));
+      if (newline) {
+        line.append(start, newline);
+        begin += newline - start + 1;
+        return true;
+      }
+      line.append(start, end - begin);
+      begin = end;
+    }
+  }
+
+  bool read_exact(std::string &out, size_t length) {
+    out.resize(length);
+    size_t done = 0;
+    while (done < length) {
+      if (begin == end && !fill()) {
+        return false;
+      }
+      const size_t n = std::min(length - done, end - begin);
+      std::memcpy(out.data() + done, buffer.data() + begin, n);
+      begin += n;
+      done += n;
+    }
+    return true;
+  }
+
+  // Parses "LENGTH PART [NAME]" and reads the input after it. Returns false
+  // at the end of the stream, and on a malformed frame with `error` set.
+  bool next(Frame &frame, std::string &error) {
+    if (!read_line(header)) {
+      return false;
+    }
+    size_t length = 0;
+    const char *header_end = header.data() + header.size();
+    auto [ptr, err] = std::from_chars(header.data(), header_end, length);
+    if (err != std::errc{} || ptr == header_end || *ptr != ' ') {
+      error = std::format("malformed frame header '{}'", header);
+      return false;
+    }
+    std::string_view rest(ptr + 1, header_end);
+    const size_t space = rest.find(' ');
+    frame.part = rest.substr(0, space);
+    frame.name = space == std::string_view::npos ? "" : rest.substr(space + 1);
+    if (frame.part != "1" && frame.part != "2" && frame.part != "both") {
+      error = std::format("part must be 1, 2 or both, got '{}'", frame.part);
+      return false;
+    }
+    if (!read_exact(frame.input, length)) {
+      error = std::format("stream ended inside the {} byte input '{}'", length,
+                          frame.name);
+      return false;
+    }
+    return true;
+  }
+};
+
+inline bool write_all(int fd, std::string_view data) {
+  while (!data.empty()) {
+    const ssize_t n = ::write(fd, data.data(), data.size());
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    data.remove_prefix(n);
+  }
+  return true;
+}
+
+// Solves a frame and appends the response lines to the string, which is
+// cleared and reused between frames.
+using FrameHandler = std::function<void(const Frame &, std::string &)>;
+
+// Serves frames until the stream ends. Returns 1 on a malformed stream.
+inline int serve_frames(int in_fd, int out_fd, const FrameHandler &handle) {
+  FrameReader reader(in_fd);
+  Frame frame;
+  std::string response, error;
+  while (reader.next(frame, error)) {
+    response.clear();
+    handle(frame, response);
+    if (!write_all(out_fd, response)) {
+      return 1;
+    }
+  }
+  if (!error.empty()) {
+    std::println(stderr, "{}", error);
+    return 1;
+  }
+  return 0;
+}
+
+// Solves the files listed on stdin, one path per line, in the order their
+// reads complete so reading the next files overlaps solving. Responses are
+// named after the paths.
+inline int serve_files(const std::string &part, const FrameHandler &handle) {
+  if (part != "1" && part != "2" && part != "both") {
+    std::println(stderr, "part must be 1, 2 or both, got '{}'", part);
+    return 1;
+  }
+  std::vector<std::string> paths;
+  for (std::string line; std::getline(std::cin, line);) {
+    if (!line.empty()) {
+      paths.push_back(line);
+    }
+  }
+
+  const size_t num_files = paths.size();
+  BulkReader reader(std::move(paths));
+  std::println(stderr, "Reading {} files with {}", num_files,
+               reader.backend());
+  Frame frame;
+  frame.part = part;
+  std::string response;
+  int result = 0;
+  while (auto read = reader.next()) {
+    response.clear();
+    if (!read->error.empty()) {
+      std::println(stderr, "Could not read {}: {}", read->path, read->error);
+      result = 1;
+      continue;
+    }
+    frame.name = std::move(read->path);
+    frame.input = std::move(read->contents);
+    handle(frame, response);
+    if (!write_all(STDOUT_FILENO, response)) {
+      return 1;
+    }
+  }
+  return result;
+}
+
+// Listens on a Unix socket and serves one connection at a time, forever.
+inline int serve_socket(const char *path, const FrameHandler &handle) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (std::strlen(path) >= sizeof(address.sun_path)) {
+    std::println(stderr, "Socket path too long: {}", path);
+    return 1;
+  }
+  std::strcpy(address.sun_path, path);
+
+  const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  unlink(path);
+  if (listener < 0 ||
+      bind(listener, reinterpret_cast<sockaddr *>(&address),
+           sizeof(address)) < 0 ||
+      listen(listener, 16) < 0) {
+    std::println(stderr, "Could not listen on {}: {}", path,
+                 std::strerror(errno));
+    return 1;
+  }
+  // A client hanging up early must not kill the server.
+  signal(SIGPIPE, SIG_IGN);
+  std::println(stderr, "Listening on {}", path);
+
+  while (true) {
+    const int connection = accept(listener, nullptr, nullptr);
+    if (connection < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      std::println(stderr, "accept failed: {}", std::strerror(errno));
+      return 1;
+    }
+    serve_frames(connection, connection, handle);
+    close(connection);
+  }
+}
+#endif // BATCH_HPP
@@ -0,0 +1,409 @@
+// Synthetic input generators for days 1-12, for measuring how the solvers
+// scale well past the size of the real inputs.
+//
+//   gen <DAY> [key=value...]
+//
+// Every generator is deterministic for a given seed (seed=2024 by default) and
+// writes a valid input for its day to stdout. See GENERATORS below for the
+// keys each day understands.
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <print>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "util.hpp"
+
+using std::cout, std::println;
+using std::string;
+
+struct Params {
+  std::map<string, string> values;
+  std::set<string> used;
+
+  uint64_t get(const string &key, uint64_t fallback) {
+    used.insert(key);
+    if (!values.contains(key)) {
+      return fallback;
+    }
+    return parse::to_uint64(values.at(key)).value_or(fallback);
+  }
+
+  double get_double(const string &key, double fallback) {
+    used.insert(key);
+    if (!values.contains(key)) {
+      return fallback;
+    }
+    return std::strtod(values.at(key).c_str(), nullptr);
+  }
+};
+
+// Buffers output so generating gigabytes isn't dominated by stream overhead.
+struct Writer {
+  string buffer;
+
+  Writer() { buffer.reserve(1 << 20); }
+  ~Writer() { flush(); }
+
+  void flush() {
+    std::fwrite(buffer.data(), 1, buffer.size(), stdout);
+    buffer.clear();
+  }
+
+  void put(char c) {
+    buffer.push_back(c);
+    if (buffer.size() >= (1 << 20)) {
+      flush();
+    }
+  }
+
+  void put(const string &s) {
+    buffer += s;
+    if (buffer.size() >= (1 << 20)) {
+      flush();
+    }
+  }
+
+  void put(uint64_t value) { put(std::to_string(value)); }
+};
+
+typedef std::mt19937_64 Rng;
+
+uint64_t uniform(Rng &rng, uint64_t low, uint64_t high) {
+  return std::uniform_int_distribution<uint64_t>(low, high)(rng);
+}
+
+bool chance(Rng &rng, double probability) {
+  return std::uniform_real_distribution<double>(0.0, 1.0)(rng) < probability;
+}
+
+// Writes a width x height grid where each cell is chosen by cell(x, y, row
+// above, row so far).
+void put_grid(Writer &out, uint64_t width, uint64_t height,
+              const std::function<char(uint64_t, uint64_t, const string &,
+                                       const string &)> &cell) {
+  string above, row;
+  for (uint64_t y = 0; y < height; ++y) {
+    row.clear();
+    for (uint64_t x = 0; x < width; ++x) {
+      row.push_back(cell(x, y, above, row));
+    }
+    out.put(row);
+    out.put('\n');
+    std::swap(above, row);
+  }
+}
+
+// lines: number of pairs, max: largest location id.
+void gen_1(Params &params, Rng &rng, Writer &out) {
+  const auto lines = params.get("lines", 1000);
+  const auto max = params.get("max", 99999);
+  for (uint64_t i = 0; i < lines; ++i) {
+    out.put(uniform(rng, 1, max));
+    out.put("   ");
+    out.put(uniform(rng, 1, max));
+    out.put('\n');
+  }
+}
+
+// lines: number of reports, length: levels per report, unsafe: chance that a
+// report gets a level that breaks it.
+void gen_2(Params &params, Rng &rng, Writer &out) {
+  const auto lines = params.get("lines", 1000);
+  const auto length = std::max<uint64_t>(params.get("length", 8), 2);
+  const auto unsafe = params.get_double("unsafe", 0.3);
+  std::vector<int64_t> levels(length);
+  for (uint64_t i = 0; i < lines; ++i) {
+    const int64_t direction = chance(rng, 0.5) ? 1 : -1;
+    levels[0] = uniform(rng, 1, 99);
+    for (uint64_t j = 1; j < length; ++j) {
+      levels[j] = levels[j - 1] + direction * int64_t(uniform(rng, 1, 3));
+    }
+    if (chance(rng, unsafe)) {
+      auto &level = levels[uniform(rng, 0, length - 1)];
+      level += int64_t(uniform(rng, 0, 8)) - 4;
+    }
+    // Shift everything up so the levels stay positive like the real ones.
+    const int64_t lowest = *std::min_element(levels.begin(), levels.end());
+    for (uint64_t j = 0; j < length; ++j) {
+      if (j > 0) {
+        out.put(' ');
+      }
+      out.put(uint64_t(levels[j] - std::min<int64_t>(lowest, 1) + 1));
+    }
+    out.put('\n');
+  }
+}
+
+// lines, width: shape of the corrupted memory, instructions: chance that a
+// position starts an instruction rather than noise.
+void gen_3(Params &params, Rng &rng, Writer &out) {
+  const auto lines = params.get("lines", 6);
+  const auto width = params.get("width", 3000);
+  const auto instructions = params.get_double("instructions", 0.05);
+  constexpr char noise[] = "!@#$%^&*()[]{}<>?+-',;:_ mulodnt";
+  for (uint64_t i = 0; i < lines; ++i) {
+    uint64_t written = 0;
+    while (written < width) {
+      string token;
+      if (chance(rng, instructions)) {
+        const auto kind = uniform(rng, 0, 9);
+        if (kind == 0) {
+          token = "do()";
+        } else if (kind == 1) {
+          token = "don't()";
+        } else if (kind == 2) {
+          // Near misses that must not match.
+          token = std::format("mul[{},{}]", uniform(rng, 1, 999),
+                              uniform(rng, 1, 999));
+        } else {
+          token = std::format("mul({},{})", uniform(rng, 1, 999),
+                              uniform(rng, 1, 999));
+        }
+      } else {
+        token = string(1, noise[uniform(rng, 0, sizeof(noise) - 2)]);
+      }
+      out.put(token);
+      written += token.size();
+    }
+    out.put('\n');
+  }
+}
+
+// size: side of a square grid, or width, height: grid size.
+void gen_4(Params &params, Rng &rng, Writer &out) {
+  const auto size = params.get("size", 140);
+  const auto width = params.get("width", size);
+  const auto height = params.get("height", size);
+  constexpr char letters[] = "XMAS";
+  put_grid(out, width, height, [&](auto, auto, const auto &, const auto &) {
+    return letters[uniform(rng, 0, 3)];
+  });
+}
+
+// pages: distinct page numbers (at most 90), updates: number of updates,
+// length: pages per update (made odd), sorted: chance an update is already in
+// order.
+void gen_5(Params &params, Rng &rng, Writer &out) {
+  const auto pages = std::clamp<uint64_t>(params.get("pages", 49), 3, 90);
+  const auto updates = params.get("updates", 200);
+  auto length = std::clamp<uint64_t>(params.get("length", 11), 3, pages);
+  // The solver takes the middle page, so updates have an odd length.
+  if (length % 2 == 0) {
+    --length;
+  }
+  const auto sorted = params.get_double("sorted", 0.5);
+
+  std::vector<uint64_t> order(90);
+  std::iota(order.begin(), order.end(), 10);
+  std::shuffle(order.begin(), order.end(), rng);
+  order.resize(pages);
+
+  // Every pair gets a rule so the ordering of any update is fully defined.
+  std::vector<std::pair<uint64_t, uint64_t>> rules;
+  for (uint64_t i = 0; i < pages; ++i) {
+    for (uint64_t j = i + 1; j < pages; ++j) {
+      rules.emplace_back(order[i], order[j]);
+    }
+  }
+  std::shuffle(rules.begin(), rules.end(), rng);
+  for (const auto &[left, right] : rules) {
+    out.put(std::format("{}|{}\n", left, right));
+  }
+  out.put('\n');
+
+  std::vector<uint64_t> indices(pages);
+  std::iota(indices.begin(), indices.end(), 0);
+  for (uint64_t i = 0; i < updates; ++i) {
+    std::shuffle(indices.begin(), indices.end(), rng);
+    std::vector<uint64_t> update(indices.begin(), indices.begin() + length);
+    if (chance(rng, sorted)) {
+      std::sort(update.begin(), update.end());
+    }
+    for (uint64_t j = 0; j < length; ++j) {
+      if (j > 0) {
+        out.put(',');
+      }
+      out.put(order[update[j]]);
+    }
+    out.put('\n');
+  }
+}
+
+// width, height: grid size, density: chance a cell is an obstruction.
+void gen_6(Params &params, Rng &rng, Writer &out) {
+  const auto width = params.get("width", 130);
+  const auto height = params.get("height", width);
+  const auto density = params.get_double("density", 0.05);
+  const auto guard_x = uniform(rng, 0, width - 1);
+  const auto guard_y = uniform(rng, 0, height - 1);
+  put_grid(out, width, height,
+           [&](auto x, auto y, const auto &, const auto &) {
+             if (x == guard_x && y == guard_y) {
+               return '^';
+             }
+             return chance(rng, density) ? '#' : '.';
+           });
+}
+
+// lines: number of equations, operands: numbers per equation, max: largest
+// operand, solvable: chance the target is built from the operands.
+void gen_7(Params &params, Rng &rng, Writer &out) {
+  const auto lines = params.get("lines", 850);
+  const auto operands = std::max<uint64_t>(params.get("operands", 8), 2);
+  const auto max = params.get("max", 999);
+  const auto solvable = params.get_double("solvable", 0.5);
+  std::vector<uint64_t> parts(operands);
+  for (uint64_t i = 0; i < lines; ++i) {
+    for (auto &part : parts) {
+      part = uniform(rng, 1, max);
+    }
+    uint64_t target = parts[0];
+    for (uint64_t j = 1; j < operands; ++j) {
+      // Fall back to + whenever another operator could overflow.
+      const auto op = uniform(rng, 0, 2);
+      if (op == 1 && target < (uint64_t(1) << 40) / parts[j]) {
+        target *= parts[j];
+      } else if (op == 2 && target < (uint64_t(1) << 40)) {
+        target = concatenate(target, parts[j]);
+      } else {
+        target += parts[j];
+      }
+    }
+    if (!chance(rng, solvable)) {
+      target += uniform(rng, 1, max);
+    }
+    out.put(target);
+    out.put(':');
+    for (const auto part : parts) {
+      out.put(' ');
+      out.put(part);
+    }
+    out.put('\n');
+  }
+}
+
+// width, height: grid size, density: chance a cell holds an antenna,
+// frequencies: number of distinct frequencies (at most 62).
+void gen_8(Params &params, Rng &rng, Writer &out) {
+  const auto width = params.get("width", 50);
+  const auto height = params.get("height", width);
+  const auto density = params.get_double("density", 0.08);
+  const auto frequencies =
+      std::clamp<uint64_t>(params.get("frequencies", 40), 1, 62);
+  constexpr char names[] =
+      "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+  put_grid(out, width, height, [&](auto, auto, const auto &, const auto &) {
+    return chance(rng, density) ? names[uniform(rng, 0, frequencies - 1)]
+                                : '.';
+  });
+}
+
+// length: number of digits in the disk map.
+void gen_9(Params &params, Rng &rng, Writer &out) {
+  const auto length = params.get("length", 19999);
+  for (uint64_t i = 0; i < length; ++i) {
+    // Files are never empty, free space can be.
+    out.put(char('0' + uniform(rng, i % 2 == 0 ? 1 : 0, 9)));
+  }
+  out.put('\n');
+}
+
+// width, height: grid size, trails: chance a cell continues an ascending
+// trail from its left or upper neighbour instead of being random.
+void gen_10(Params &params, Rng &rng, Writer &out) {
+  const auto width = params.get("width", 50);
+  const auto height = params.get("height", width);
+  const auto trails = params.get_double("trails", 0.75);
+  put_grid(out, width, height,
+           [&](auto x, auto y, const string &above, const string &row) {
+             if (chance(rng, trails) && (x > 0 || y > 0)) {
+               const bool from_left = y == 0 || (x > 0 && chance(rng, 0.5));
+               const char previous = from_left ? row[x - 1] : above[x];
+               return char('0' + (previous - '0' + 1) % 10);
+             }
+             return char('0' + uniform(rng, 0, 9));
+           });
+}
+
+// count: number of stones, max: largest engraving.
+void gen_11(Params &params, Rng &rng, Writer &out) {
+  const auto count = params.get("count", 8);
+  const auto max = params.get("max", 9999999);
+  for (uint64_t i = 0; i < count; ++i) {
+    if (i > 0) {
+      out.put(' ');
+    }
+    out.put(uniform(rng, 0, max));
+  }
+  out.put('\n');
+}
+
+// width, height: grid size, plants: number of plant types (at most 26),
+// merge: chance a plot copies its left or upper neighbour, which controls how
+// large the regions get.
+void gen_12(Params &params, Rng &rng, Writer &out) {
+  const auto width = params.get("width", 140);
+  const auto height = params.get("height", width);
+  const auto plants = std::clamp<uint64_t>(params.get("plants", 26), 1, 26);
+  const auto merge = params.get_double("merge", 0.85);
+  put_grid(out, width, height,
+           [&](auto x, auto y, const string &above, const string &row) {
+             if (chance(rng, merge) && (x > 0 || y > 0)) {
+               const bool from_left = y == 0 || (x > 0 && chance(rng, 0.5));
+               return from_left ? row[x - 1] : above[x];
+             }
+             return char('A' + uniform(rng, 0, plants - 1));
+           });
+}
+
+const std::map<int, std::function<void(Params &, Rng &, Writer &)>>
+    GENERATORS{{1, gen_1}, {2, gen_2},   {3, gen_3},   {4, gen_4},
+               {5, gen_5}, {6, gen_6},   {7, gen_7},   {8, gen_8},
+               {9, gen_9}, {10, gen_10}, {11, gen_11}, {12, gen_12}};
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    println(std::cerr, "usage: {} <DAY> [key=value...]", argv[0]);
+    return 1;
+  }
+  const auto day = parse::to_int(argv[1]);
+  if (!day || !GENERATORS.contains(*day)) {
+    println(std::cerr, "no generator for day {}", argv[1]);
+    return 1;
+  }
+
+  Params params;
+  for (int i = 2; i < argc; ++i) {
+    const string arg(argv[i]);
+    const auto equals = arg.find('=');
+    if (equals == string::npos) {
+      println(std::cerr, "expected key=value, got {}", arg);
+      return 1;
+    }
+    params.values[arg.substr(0, equals)] = arg.substr(equals + 1);
+  }
+
+  Rng rng(params.get("seed", 2024));
+  {
+    Writer out;
+    GENERATORS.at(*day)(params, rng, out);
+  }
+
+  for (const auto &[key, _] : params.values) {
+    if (!params.used.contains(key)) {
+      println(std::cerr, "day {} ignores {}", *day, key);
+      return 1;
+    }
+  }
+  return 0;
+}
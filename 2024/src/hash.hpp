@@ -0,0 +1,232 @@
+#pragma once
+#ifndef HASH_HPP
+#define HASH_HPP
+// Hashes for the days' keys and flat hash containers to put them in.
+//
+// std::hash of an integer is the integer itself in libstdc++, so combining
+// two with XOR makes (1, 2) and (2, 1) collide and sends every (x, x) to 0.
+// The hashes here mix every input bit into every output bit instead.
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// The finalizer of MurmurHash3.
+constexpr uint64_t mix64(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+// Unlike XOR, hash_combine(a, b) != hash_combine(b, a).
+constexpr uint64_t hash_combine(uint64_t seed, uint64_t value) {
+  return mix64(seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) +
+                       (seed >> 2)));
+}
+
+// Two 32 bit values fit in one 64 bit key, so they only need one mix.
+constexpr uint64_t hash_pair32(uint32_t a, uint32_t b) {
+  return mix64(uint64_t(a) << 32 | b);
+}
+
+// An open addressing hash set (Value = void) or map with linear probing. The
+// elements live in one array instead of a node each, and a byte per slot holds
+// 7 bits of the hash so most mismatches are rejected without comparing keys.
+//
+// Keys and values have to be default constructible, and elements can't be
+// erased. Pointers and iterators are invalidated by inserts. The storage comes
+// from the memory resource it is constructed with (see arena.hpp), and copies
+// use the default one.
+template <typename Key, typename Value = void, typename Hash = std::hash<Key>,
+          typename Equal = std::equal_to<Key>>
+struct FlatTable {
+  static constexpr bool is_map = !std::is_void_v<Value>;
+  using value_type = std::conditional_t<is_map, std::pair<Key, Value>, Key>;
+
+  // 0 for an empty slot, otherwise 0x80 | 7 bits of the hash.
+  std::pmr::vector<uint8_t> control;
+  std::pmr::vector<value_type> slots;
+  size_t count = 0;
+  size_t mask = 0;
+  int shift = 64;
+  [[no_unique_address]] Hash hasher;
+  [[no_unique_address]] Equal equal;
+
+  FlatTable() = default;
+  explicit FlatTable(std::pmr::memory_resource *resource)
+      : control(resource), slots(resource) {}
+
+  template <typename Table, typename Reference> struct Iterator {
+    Table *table;
+    size_t index;
+
+    Reference operator*() const { return table->slots[index]; }
+    auto operator->() const { return &table->slots[index]; }
+    Iterator &operator++() {
+      ++index;
+      skip_empty();
+      return *this;
+    }
+    bool operator==(const Iterator &rhs) const { return index == rhs.index; }
+
+    void skip_empty() {
+      while (index < table->control.size() && !table->control[index]) {
+        ++index;
+      }
+    }
+  };
+  using const_iterator = Iterator<const FlatTable, const value_type &>;
+  // Keys of a set can't be changed in place.
+  using iterator = std::conditional_t<is_map, Iterator<FlatTable, value_type &>,
+                                      const_iterator>;
+
+  static const Key &key_of(const value_type &value) {
+    if constexpr (is_map) {
+      return value.first;
+    } else {
+      return value;
+    }
+  }
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  size_t capacity() const { return control.size(); }
+
+  iterator begin() {
+    iterator it{this, 0};
+    it.skip_empty();
+    return it;
+  }
+  iterator end() { return {this, capacity()}; }
+  const_iterator begin() const {
+    const_iterator it{this, 0};
+    it.skip_empty();
+    return it;
+  }
+  const_iterator end() const { return {this, capacity()}; }
+
+  // Keeps the capacity, so refilling it doesn't allocate.
+  void clear() {
+    std::fill(control.begin(), control.end(), 0);
+    count = 0;
+  }
+
+  void reserve(size_t n) {
+    // At most 3/4 full.
+    const size_t needed = std::bit_ceil(std::max<size_t>(16, n * 4 / 3 + 1));
+    if (needed > capacity()) {
+      rehash(needed);
+    }
+  }
+
+  // The slot holding the key, or the empty slot where it belongs.
+  size_t probe(const Key &key, uint8_t &tag) const {
+    // Multiplying spreads hashes that are only good in their low bits (like
+    // std::hash<int>) over the high bits the index comes from.
+    const uint64_t h = uint64_t(hasher(key)) * 0x9e3779b97f4a7c15ULL;
+    tag = 0x80 | (h & 0x7f);
+    for (size_t i = h >> shift;; i = (i + 1) & mask) {
+      if (!control[i] || (control[i] == tag && equal(key_of(slots[i]), key))) {
+        return i;
+      }
+    }
+  }
+
+  void rehash(size_t new_capacity) {
+    auto old_control = std::move(control);
+    auto old_slots = std::move(slots);
+    control.assign(new_capacity, 0);
+    slots.clear();
+    slots.resize(new_capacity);
+    mask = new_capacity - 1;
+    shift = 64 - std::countr_zero(new_capacity);
+    for (size_t i = 0; i < old_control.size(); ++i) {
+      if (old_control[i]) {
+        uint8_t tag;
+        const size_t j = probe(key_of(old_slots[i]), tag);
+        control[j] = tag;
+        slots[j] = std::move(old_slots[i]);
+      }
+    }
+  }
+
+  // The slot of the key and whether it was inserted, with a default value for
+  // maps.
+  std::pair<size_t, bool> find_or_insert(const Key &key) {
+    if ((count + 1) * 4 > capacity() * 3) {
+      rehash(std::max<size_t>(16, capacity() * 2));
+    }
+    uint8_t tag;
+    const size_t i = probe(key, tag);
+    if (control[i]) {
+      return {i, false};
+    }
+    control[i] = tag;
+    if constexpr (is_map) {
+      slots[i] = value_type{key, Value{}};
+    } else {
+      slots[i] = key;
+    }
+    ++count;
+    return {i, true};
+  }
+
+  std::pair<iterator, bool> insert(const value_type &value) {
+    const auto [i, inserted] = find_or_insert(key_of(value));
+    if constexpr (is_map) {
+      if (inserted) {
+        slots[i].second = value.second;
+      }
+    }
+    return {iterator{this, i}, inserted};
+  }
+
+  template <typename It> void insert(It first, It last) {
+    for (; first != last; ++first) {
+      insert(*first);
+    }
+  }
+
+  template <typename V = Value>
+    requires(!std::is_void_v<V>)
+  V &operator[](const Key &key) {
+    return slots[find_or_insert(key).first].second;
+  }
+
+  iterator find(const Key &key) {
+    if (empty()) {
+      return end();
+    }
+    uint8_t tag;
+    const size_t i = probe(key, tag);
+    return control[i] ? iterator{this, i} : end();
+  }
+
+  const_iterator find(const Key &key) const {
+    if (empty()) {
+      return end();
+    }
+    uint8_t tag;
+    const size_t i = probe(key, tag);
+    return control[i] ? const_iterator{this, i} : end();
+  }
+
+  bool contains(const Key &key) const { return find(key) != end(); }
+};
+
+template <typename Key, typename Hash = std::hash<Key>,
+          typename Equal = std::equal_to<Key>>
+using FlatSet = FlatTable<Key, void, Hash, Equal>;
+
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename Equal = std::equal_to<Key>>
+using FlatMap = FlatTable<Key, Value, Hash, Equal>;
+#endif // HASH_HPP
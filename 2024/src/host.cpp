@@ -0,0 +1,169 @@
+// Keeps a day's input loaded and re-runs the day whenever its source or a
+// header changes, by rebuilding it as a shared object and reloading that
+// instead of relaunching a binary. A save costs the compile plus the solve.
+//
+//   host <DAY> <INPUT>
+//
+// Run from the directory with src/, like the scripts. The day is built with
+// `make build/$BUILD/<DAY>.so` (BUILD from the environment, release by
+// default), which defines AOC_SHARED. That makes its main() register the parts
+// in aoc_hosted_day instead of running them (see run_day() in util.hpp).
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <print>
+#include <sstream>
+#include <string>
+
+#include <dlfcn.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "util.hpp"
+
+using std::cout, std::println;
+using std::string;
+
+namespace fs = std::filesystem;
+
+const fs::path SOURCE_DIR = "src";
+const string BUILD = std::getenv("BUILD") ? std::getenv("BUILD") : "release";
+const fs::path BUILD_DIR = fs::path("build") / BUILD;
+const fs::path LOAD_DIR = BUILD_DIR / "hosted";
+
+struct LoadedDay {
+  void *handle = nullptr;
+  fs::path path;
+
+  ~LoadedDay() {
+    if (handle) {
+      dlclose(handle);
+    }
+    fs::remove(path);
+  }
+};
+
+int64_t milliseconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Builds and loads the day, then solves the input with it. Every build is
+// moved to its own path since dlopen() returns the already loaded object for a
+// path it has seen, which also has make build it again next time.
+std::unique_ptr<LoadedDay> reload(const string &day, int generation,
+                                  const string &input) {
+  const fs::path built = BUILD_DIR / (day + ".so");
+  const string command =
+      std::format("make -s BUILD={} {}", BUILD, built.string());
+
+  const auto build_start = std::chrono::steady_clock::now();
+  if (std::system(command.c_str()) != 0) {
+    println(cout, "\033[1;31mBuild failed\033[0m");
+    return nullptr;
+  }
+  const auto build_ms = milliseconds_since(build_start);
+  auto loaded = std::make_unique<LoadedDay>();
+  loaded->path = LOAD_DIR / std::format("{}.{}.so", day, generation);
+  fs::rename(built, loaded->path);
+
+  loaded->handle = dlopen(loaded->path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (!loaded->handle) {
+    println(cout, "\033[1;31m{}\033[0m", dlerror());
+    return nullptr;
+  }
+  auto *day_main = reinterpret_cast<int (*)()>(dlsym(loaded->handle, "main"));
+  auto *hosted =
+      static_cast<HostedDay *>(dlsym(loaded->handle, "aoc_hosted_day"));
+  if (!day_main || !hosted) {
+    println(cout, "\033[1;31mDay {} does not end with run_day()\033[0m", day);
+    return nullptr;
+  }
+  day_main();
+
+  if (isatty(STDOUT_FILENO)) {
+    std::print(cout, "\033[2J\033[H");
+  }
+  try {
+    hosted->run(input);
+  } catch (...) {
+    println(cout, "\033[1;31mDay {} threw\033[0m", day);
+  }
+  println(cout, "Built in {} ms, watching {} for changes", build_ms,
+          SOURCE_DIR.string());
+  cout.flush();
+  return loaded;
+}
+
+// Waits for a write to the day's source or any header, then for the editor to
+// settle so one save means one rebuild.
+bool wait_for_change(int inotify_fd, const string &day) {
+  alignas(inotify_event) char buffer[4096];
+  bool changed = false;
+  while (true) {
+    pollfd fd{inotify_fd, POLLIN, 0};
+    const int ready = poll(&fd, 1, changed ? 50 : -1);
+    if (ready < 0) {
+      return false;
+    }
+    if (ready == 0) {
+      return true;
+    }
+    const ssize_t length = read(inotify_fd, buffer, sizeof(buffer));
+    if (length <= 0) {
+      return false;
+    }
+    for (ssize_t offset = 0; offset < length;) {
+      const auto *event = reinterpret_cast<inotify_event *>(buffer + offset);
+      const fs::path name = event->len ? event->name : "";
+      if (name == day + ".cpp" || name.extension() == ".hpp") {
+        changed = true;
+      }
+      offset += sizeof(inotify_event) + event->len;
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    println(std::cerr, "Usage: {} <DAY> <INPUT>", argv[0]);
+    return 1;
+  }
+  const string day = argv[1];
+
+  std::ifstream file(argv[2]);
+  if (!file) {
+    println(std::cerr, "Could not open {}", argv[2]);
+    return 1;
+  }
+  std::ostringstream buffer;
+  buffer << file.rdbuf();
+  const string input = buffer.str();
+
+  fs::create_directories(LOAD_DIR);
+  const int inotify_fd = inotify_init1(IN_CLOEXEC);
+  // Editors often save by writing a new file and renaming it over the old.
+  if (inotify_fd < 0 ||
+      inotify_add_watch(inotify_fd, SOURCE_DIR.c_str(),
+                        IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+    println(std::cerr, "Could not watch {}", SOURCE_DIR.string());
+    return 1;
+  }
+
+  std::unique_ptr<LoadedDay> loaded;
+  for (int generation = 0;; ++generation) {
+    // Unload the previous build first so its thread pool is gone before the
+    // new one starts.
+    loaded.reset();
+    loaded = reload(day, generation, input);
+    if (!wait_for_change(inotify_fd, day)) {
+      return 1;
+    }
+  }
+}
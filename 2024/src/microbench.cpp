@@ -0,0 +1,622 @@
+// Microbenchmarks for the helpers in util.hpp and thirdpartyutils.hpp that
+// every day leans on.
+//
+//   microbench [FILTER...]
+//
+// Only benchmarks whose name contains one of the filters run. Each one is
+// repeated until it has run for at least 100ms and reports ns per operation,
+// and throughput where an operation has a meaningful size in bytes. GridPaths
+// is checked against a plain Dijkstra first, and a mismatch exits with 1.
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <print>
+#include <queue>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "thirdpartyutils.hpp"
+#include "util.hpp"
+
+using std::cout, std::println;
+using std::string;
+
+// Keeps the compiler from discarding a result that is never used.
+template <typename T> inline void do_not_optimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Microbench {
+  std::vector<string> filters;
+
+  bool selected(const string &name) const {
+    if (filters.empty()) {
+      return true;
+    }
+    for (const auto &filter : filters) {
+      if (name.find(filter) != string::npos) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // op runs `ops_per_call` operations covering `bytes_per_call` bytes of
+  // input per call.
+  void run(const string &name, uint64_t ops_per_call, uint64_t bytes_per_call,
+           const std::function<void()> &op) const {
+    if (!selected(name)) {
+      return;
+    }
+    using clock = std::chrono::steady_clock;
+    constexpr auto min_duration = std::chrono::milliseconds(100);
+
+    op(); // Warm up caches and the allocator.
+    uint64_t calls = 0;
+    const auto start = clock::now();
+    auto elapsed = clock::duration::zero();
+    for (uint64_t batch = 1; elapsed < min_duration; batch *= 2) {
+      for (uint64_t i = 0; i < batch; ++i) {
+        op();
+      }
+      calls += batch;
+      elapsed = clock::now() - start;
+    }
+
+    const double ns =
+        std::chrono::duration<double, std::nano>(elapsed).count();
+    const double ns_per_op = ns / double(calls * ops_per_call);
+    if (bytes_per_call > 0) {
+      const double mb_per_s = double(calls * bytes_per_call) / ns * 1000.0;
+      println(cout, "{:<44} {:>12.2f} ns/op {:>10.1f} MB/s", name, ns_per_op,
+              mb_per_s);
+    } else {
+      println(cout, "{:<44} {:>12.2f} ns/op", name, ns_per_op);
+    }
+  }
+};
+
+std::mt19937_64 rng(2024);
+
+// Numbers whose digit count is uniform in [1, max_digits] (at most 19), which
+// is closer to real inputs than values uniform in [0, 10^max_digits).
+std::vector<uint64_t> numbers_with_digits(size_t count, int max_digits) {
+  std::vector<uint64_t> out(count);
+  std::uniform_int_distribution<int> digits(1, max_digits);
+  for (auto &value : out) {
+    const int n = digits(rng);
+    uint64_t low = 1;
+    for (int i = 1; i < n; ++i) {
+      low *= 10;
+    }
+    const uint64_t high = low * 10 - 1;
+    value = std::uniform_int_distribution<uint64_t>(n == 1 ? 0 : low,
+                                                    high)(rng);
+  }
+  return out;
+}
+
+string grid_input(size_t side,
+                  std::string_view alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZ") {
+  string out;
+  out.reserve(side * (side + 1));
+  std::uniform_int_distribution<size_t> letter(0, alphabet.size() - 1);
+  for (size_t y = 0; y < side; ++y) {
+    for (size_t x = 0; x < side; ++x) {
+      out.push_back(alphabet[letter(rng)]);
+    }
+    out.push_back('\n');
+  }
+  return out;
+}
+
+void bench_split(const Microbench &bench) {
+  for (const size_t tokens : {2, 8, 64, 1024}) {
+    const auto numbers = numbers_with_digits(tokens, 5);
+    string line;
+    for (const auto number : numbers) {
+      line += std::format("{} ", number);
+    }
+    bench.run(std::format("split/to_int/{}_tokens", tokens), tokens,
+              line.size(),
+              [&] { do_not_optimize(split(line, ' ', parse::to_int)); });
+    bench.run(std::format("split/to_string/{}_tokens", tokens), tokens,
+              line.size(),
+              [&] { do_not_optimize(split(line, ' ', parse::to_string)); });
+  }
+}
+
+void bench_parse(const Microbench &bench) {
+  constexpr size_t count = 4096;
+  for (const int digits : {1, 3, 9}) {
+    std::vector<string> tokens;
+    size_t bytes = 0;
+    for (const auto number : numbers_with_digits(count, digits)) {
+      tokens.push_back(std::to_string(number));
+      bytes += tokens.back().size();
+    }
+    bench.run(std::format("parse::to_int/1-{}_digits", digits), count, bytes,
+              [&] {
+                for (const auto &token : tokens) {
+                  do_not_optimize(parse::to_int(token));
+                }
+              });
+  }
+  for (const int digits : {1, 9, 19}) {
+    std::vector<string> tokens;
+    size_t bytes = 0;
+    for (const auto number : numbers_with_digits(count, digits)) {
+      tokens.push_back(std::to_string(number));
+      bytes += tokens.back().size();
+    }
+    bench.run(std::format("parse::to_uint64/1-{}_digits", digits), count,
+              bytes, [&] {
+                for (const auto &token : tokens) {
+                  do_not_optimize(parse::to_uint64(token));
+                }
+              });
+  }
+}
+
+void bench_digits(const Microbench &bench) {
+  constexpr size_t count = 4096;
+  for (const int digits : {3, 9, 19}) {
+    const auto numbers = numbers_with_digits(count, digits);
+    bench.run(std::format("get_num_digits/1-{}_digits", digits), count, 0,
+              [&] {
+                for (const auto number : numbers) {
+                  do_not_optimize(get_num_digits(number));
+                }
+              });
+  }
+
+  // Day 7's | operator: both sides small enough not to overflow.
+  const auto left = numbers_with_digits(count, 9);
+  const auto right = numbers_with_digits(count, 3);
+  bench.run("concatenate/1-9_and_1-3_digits", count, 0, [&] {
+    for (size_t i = 0; i < count; ++i) {
+      do_not_optimize(concatenate(left[i], right[i]));
+    }
+  });
+
+  // Day 11's stones: even digit counts split in half.
+  std::vector<uint64_t> even;
+  for (const auto number : numbers_with_digits(count * 2, 12)) {
+    if (get_num_digits(number) % 2 == 0) {
+      even.push_back(number);
+    }
+  }
+  bench.run("split_number/even_1-12_digits", even.size(), 0, [&] {
+    for (const auto number : even) {
+      do_not_optimize(split_number(number, get_num_digits(number) / 2));
+    }
+  });
+}
+
+void bench_grid(const Microbench &bench) {
+  for (const size_t side : {64, 512, 2048}) {
+    const string input = grid_input(side);
+    bench.run(std::format("CharGrid/construct/{}x{}", side, side), 1,
+              input.size(), [&] { do_not_optimize(CharGrid(input)); });
+    bench.run(std::format("CharGrid/view/{}x{}", side, side), 1, input.size(),
+              [&] { do_not_optimize(CharGrid::view(input)); });
+
+    const CharGrid grid(input);
+    bench.run(std::format("CharGrid/at/sequential/{}x{}", side, side),
+              side * side, side * side, [&] {
+                uint64_t sum = 0;
+                for (size_t y = 0; y < side; ++y) {
+                  for (size_t x = 0; x < side; ++x) {
+                    sum += grid.at(x, y);
+                  }
+                }
+                do_not_optimize(sum);
+              });
+    bench.run(std::format("CharGrid/unchecked/sequential/{}x{}", side, side),
+              side * side, side * side, [&] {
+                uint64_t sum = 0;
+                for (size_t y = 0; y < side; ++y) {
+                  for (size_t x = 0; x < side; ++x) {
+                    sum += grid(x, y);
+                  }
+                }
+                do_not_optimize(sum);
+              });
+    bench.run(std::format("CharGrid/row/{}x{}", side, side), side * side,
+              side * side, [&] {
+                uint64_t sum = 0;
+                for (size_t y = 0; y < side; ++y) {
+                  for (const char c : grid.row(y)) {
+                    sum += c;
+                  }
+                }
+                do_not_optimize(sum);
+              });
+    bench.run(std::format("CharGrid/at/column_major/{}x{}", side, side),
+              side * side, side * side, [&] {
+                uint64_t sum = 0;
+                for (size_t x = 0; x < side; ++x) {
+                  for (size_t y = 0; y < side; ++y) {
+                    sum += grid.at(x, y);
+                  }
+                }
+                do_not_optimize(sum);
+              });
+  }
+}
+
+// Counting one letter of Day 4's alphabet, and one height of Day 10's, a char
+// at a time against a word of packed cells at a time.
+template <int Bits>
+void bench_packed_grid(const Microbench &bench, std::string_view alphabet) {
+  for (const size_t side : {64, 512, 2048}) {
+    const string input = grid_input(side, alphabet);
+    const CharGrid grid = CharGrid::view(input);
+    bench.run(std::format("PackedGrid<{}>/encode/{}x{}", Bits, side, side), 1,
+              input.size(), [&] {
+                do_not_optimize(PackedGrid<Bits>::encode(grid, alphabet));
+              });
+
+    const auto packed = *PackedGrid<Bits>::encode(grid, alphabet);
+    bench.run(std::format("CharGrid/count/{}/{}x{}", alphabet, side, side),
+              side * side, side * side, [&] {
+                size_t count = 0;
+                for (size_t y = 0; y < side; ++y) {
+                  for (const char c : grid.row(y)) {
+                    count += c == alphabet[0];
+                  }
+                }
+                do_not_optimize(count);
+              });
+    bench.run(std::format("PackedGrid<{}>/count/{}x{}", Bits, side, side),
+              side * side, side * side, [&] {
+                size_t count = 0;
+                for (size_t y = 0; y < side; ++y) {
+                  count += packed.count(y, 0);
+                }
+                do_not_optimize(count);
+              });
+  }
+}
+
+// Hashing every point of a grid into a set is what Days 8, 10 and 12 do, so
+// the set benchmarks show the cost of collisions, not just of the hash. The
+// std::unordered_set ones are the baseline for FlatSet, and the scratch one
+// shows what allocating from the arena saves. BitGrid is what a set of points
+// on a grid becomes when the grid's size is known.
+void bench_hash(const Microbench &bench) {
+  for (const int side : {64, 512}) {
+    std::vector<Point> points;
+    for (int y = 0; y < side; ++y) {
+      for (int x = 0; x < side; ++x) {
+        points.emplace_back(x, y);
+      }
+    }
+    bench.run(std::format("hash<Point>/grid/{}x{}", side, side), points.size(),
+              0, [&] {
+                size_t h = 0;
+                for (const auto &point : points) {
+                  h += std::hash<Point>{}(point);
+                }
+                do_not_optimize(h);
+              });
+    bench.run(std::format("unordered_set<Point>/insert/{}x{}", side, side),
+              points.size(), 0, [&] {
+                std::unordered_set<Point> set;
+                for (const auto &point : points) {
+                  set.insert(point);
+                }
+                do_not_optimize(set.size());
+              });
+    bench.run(std::format("FlatSet<Point>/insert/{}x{}", side, side),
+              points.size(), 0, [&] {
+                FlatSet<Point> set;
+                for (const auto &point : points) {
+                  set.insert(point);
+                }
+                do_not_optimize(set.size());
+              });
+    bench.run(std::format("FlatSet<Point>/insert/scratch/{}x{}", side, side),
+              points.size(), 0, [&] {
+                ScratchScope scratch;
+                FlatSet<Point> set(scratch_resource());
+                for (const auto &point : points) {
+                  set.insert(point);
+                }
+                do_not_optimize(set.size());
+              });
+    FlatSet<Point> flat_points;
+    flat_points.insert(points.begin(), points.end());
+    bench.run(std::format("FlatSet<Point>/contains/{}x{}", side, side),
+              points.size(), 0, [&] {
+                size_t found = 0;
+                for (const auto &point : points) {
+                  found += flat_points.contains(Point(point.y, point.x));
+                }
+                do_not_optimize(found);
+              });
+    bench.run(std::format("BitGrid/set/{}x{}", side, side), points.size(), 0,
+              [&] {
+                BitGrid grid(side, side);
+                for (const auto &point : points) {
+                  grid.set(point.x, point.y);
+                }
+                do_not_optimize(grid.count());
+              });
+    BitGrid bit_points(side, side);
+    for (const auto &point : points) {
+      bit_points.set(point.x, point.y);
+    }
+    bench.run(std::format("BitGrid/test/{}x{}", side, side), points.size(), 0,
+              [&] {
+                size_t found = 0;
+                for (const auto &point : points) {
+                  found += bit_points.test(point.y, point.x);
+                }
+                do_not_optimize(found);
+              });
+
+    std::vector<Line> lines;
+    for (size_t i = 0; i + 1 < points.size(); i += 2) {
+      lines.emplace_back(points[i], points[i + 1]);
+    }
+    bench.run(std::format("unordered_set<Line>/insert/{}x{}", side, side),
+              lines.size(), 0, [&] {
+                std::unordered_set<Line> set;
+                for (const auto &line : lines) {
+                  set.insert(line);
+                }
+                do_not_optimize(set.size());
+              });
+
+    std::vector<std::pair<uint64_t, uint64_t>> pairs;
+    for (const auto &point : points) {
+      pairs.emplace_back(point.x, point.y);
+    }
+    bench.run(std::format("unordered_set<pair>/insert/{}x{}", side, side),
+              pairs.size(), 0, [&] {
+                std::unordered_set<std::pair<uint64_t, uint64_t>> set;
+                for (const auto &pair : pairs) {
+                  set.insert(pair);
+                }
+                do_not_optimize(set.size());
+              });
+    bench.run(std::format("FlatSet<pair>/insert/{}x{}", side, side),
+              pairs.size(), 0, [&] {
+                FlatSet<std::pair<uint64_t, uint64_t>> set;
+                for (const auto &pair : pairs) {
+                  set.insert(pair);
+                }
+                do_not_optimize(set.size());
+              });
+  }
+}
+
+void bench_distinct_pairs(const Microbench &bench) {
+  for (const int n : {4, 64, 1024}) {
+    std::vector<Point> points;
+    for (int i = 0; i < n; ++i) {
+      points.emplace_back(i, n - i);
+    }
+    const uint64_t num_pairs = uint64_t(n) * (n - 1) / 2;
+    bench.run(std::format("distinct_pairs/iterate/{}", n), num_pairs, 0, [&] {
+      int64_t sum = 0;
+      for (const auto &pair : cdistinct_pairs(points)) {
+        sum += pair.first.x - pair.second.y;
+      }
+      do_not_optimize(sum);
+    });
+    bench.run(std::format("distinct_pairs/random_access/{}", n), 64, 0, [&] {
+      const auto range = cdistinct_pairs(points);
+      auto begin = range.begin();
+      int64_t sum = 0;
+      for (uint64_t i = 0; i < 64; ++i) {
+        sum += begin[(i * 7919) % num_pairs].first.x;
+      }
+      do_not_optimize(sum);
+    });
+  }
+}
+
+// Dijkstra with std::priority_queue and a map of distances, what GridPaths
+// replaces.
+template <typename Edges>
+uint32_t dijkstra_with_maps(const CharGrid &grid, const GridState &start,
+                            const Point &goal, Edges &&edges) {
+  const auto key = [&](const GridState &s) {
+    return (uint64_t(s.y) * grid.width + s.x) * 4 + s.direction;
+  };
+  std::unordered_map<uint64_t, uint32_t> distances{{key(start), 0}};
+  std::priority_queue<std::pair<uint32_t, uint64_t>,
+                      std::vector<std::pair<uint32_t, uint64_t>>,
+                      std::greater<>>
+      queue;
+  queue.emplace(0, key(start));
+  while (!queue.empty()) {
+    const uint32_t distance = queue.top().first;
+    const uint64_t k = queue.top().second;
+    queue.pop();
+    if (distance != distances[k]) {
+      continue;
+    }
+    const GridState from{int(k / 4 % grid.width), int(k / 4 / grid.width),
+                         int(k % 4)};
+    if (from.x == goal.x && from.y == goal.y) {
+      return distance;
+    }
+    edges(from, [&](const GridState &to, uint32_t cost) {
+      if (!grid.contains(to.x, to.y)) {
+        return;
+      }
+      const auto [it, inserted] =
+          distances.try_emplace(key(to), distance + cost);
+      if (!inserted) {
+        if (distance + cost >= it->second) {
+          return;
+        }
+        it->second = distance + cost;
+      }
+      queue.emplace(distance + cost, key(to));
+    });
+  }
+  return std::numeric_limits<uint32_t>::max();
+}
+
+// Compares GridPaths with dijkstra_with_maps on small random mazes, and
+// bfs01() and a_star() with dijkstra(). A tracked path must run from the start
+// to the goal and cost exactly its distance.
+bool check_grid_paths() {
+  bool ok = true;
+  const auto expect = [&](bool holds, const string &what) {
+    if (!holds) {
+      println(std::cerr, "GridPaths check failed: {}", what);
+      ok = false;
+    }
+  };
+  for (int trial = 0; trial < 200 && ok; ++trial) {
+    const int width = 1 + rng() % 24, height = 1 + rng() % 24;
+    string input;
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        input.push_back(rng() % 4 ? '.' : '#');
+      }
+      input.push_back('\n');
+    }
+    const CharGrid grid(input);
+    const GridState start{int(rng() % width), int(rng() % height),
+                          int(rng() % 4)};
+    const Point goal(rng() % width, rng() % height);
+    const auto at_goal = [&](const GridState &s) {
+      return s.x == goal.x && s.y == goal.y;
+    };
+    const auto reindeer = [&](const GridState &from, auto &&relax) {
+      const GridState ahead = from.forward();
+      if (grid(ahead.x, ahead.y) == '.') {
+        relax(ahead, 1);
+      }
+      relax(from.turned(1), 1000);
+      relax(from.turned(-1), 1000);
+    };
+    const auto manhattan = [&](const GridState &s) {
+      return uint32_t(std::abs(goal.x - s.x) + std::abs(goal.y - s.y));
+    };
+    const auto walls = [&](const GridState &from, auto &&relax) {
+      for (int direction = 0; direction < 4; ++direction) {
+        const GridState to = GridState{from.x, from.y, direction}.forward();
+        relax(to, grid(to.x, to.y) == '#');
+      }
+    };
+    const string name = std::format("trial {}", trial);
+
+    GridPaths<4> tracked(grid, true);
+    const uint32_t distance = tracked.dijkstra({start}, reindeer, at_goal);
+    expect(distance == dijkstra_with_maps(grid, start, goal, reindeer),
+           name + " dijkstra");
+    if (distance != tracked.UNREACHED) {
+      const auto path = tracked.path_to(tracked.goal);
+      uint32_t cost = 0;
+      for (size_t i = 1; i < path.size(); ++i) {
+        const bool turned = path[i].x == path[i - 1].x &&
+                            path[i].y == path[i - 1].y;
+        cost += turned ? 1000 : 1;
+      }
+      expect(!path.empty() && path.front() == start && at_goal(path.back()) &&
+                 cost == distance,
+             name + " path_to");
+    }
+    expect(tracked.a_star({start}, reindeer, manhattan, at_goal) == distance,
+           name + " a_star");
+
+    GridPaths<4> untracked(grid);
+    untracked.dijkstra({start}, reindeer, at_goal);
+    expect(untracked.path_to(untracked.goal).empty(),
+           name + " path_to without tracking");
+
+    GridPaths<1> cells(grid);
+    const uint32_t walls_broken = cells.dijkstra({start}, walls, at_goal);
+    expect(cells.bfs01({start}, walls, at_goal) == walls_broken,
+           name + " bfs01");
+  }
+  return ok;
+}
+
+// Corner to corner across a maze with a wall in 1 of 5 cells, where turning
+// costs 1000 steps.
+void bench_grid_paths(const Microbench &bench) {
+  for (const size_t side : {256, 1024}) {
+    const string input = grid_input(side, "....#");
+    const CharGrid grid(input);
+    const GridState start{0, 0, 0};
+    const Point goal(side - 1, side - 1);
+    const auto at_goal = [&](const GridState &s) {
+      return s.x == goal.x && s.y == goal.y;
+    };
+    const auto reindeer = [&](const GridState &from, auto &&relax) {
+      const GridState ahead = from.forward();
+      if (grid(ahead.x, ahead.y) == '.') {
+        relax(ahead, 1);
+      }
+      relax(from.turned(1), 1000);
+      relax(from.turned(-1), 1000);
+    };
+    const auto manhattan = [&](const GridState &s) {
+      return uint32_t(goal.x - s.x + goal.y - s.y);
+    };
+    // The fewest walls to break through.
+    const auto walls = [&](const GridState &from, auto &&relax) {
+      for (int direction = 0; direction < 4; ++direction) {
+        const GridState to = GridState{from.x, from.y, direction}.forward();
+        relax(to, grid(to.x, to.y) == '#');
+      }
+    };
+
+    GridPaths<1> cells(grid);
+    GridPaths<4> states(grid);
+    GridPaths<4> tracked(grid, true);
+    bench.run(std::format("GridPaths<1>/bfs01/{}x{}", side, side), side * side,
+              0,
+              [&] { do_not_optimize(cells.bfs01({start}, walls, at_goal)); });
+    bench.run(std::format("GridPaths<4>/dijkstra/{}x{}", side, side),
+              side * side, 0, [&] {
+                do_not_optimize(states.dijkstra({start}, reindeer, at_goal));
+              });
+    bench.run(std::format("GridPaths<4>/a_star/{}x{}", side, side),
+              side * side, 0, [&] {
+                do_not_optimize(
+                    states.a_star({start}, reindeer, manhattan, at_goal));
+              });
+    bench.run(std::format("GridPaths<4>/a_star/path/{}x{}", side, side),
+              side * side, 0, [&] {
+                tracked.a_star({start}, reindeer, manhattan, at_goal);
+                do_not_optimize(tracked.path_to(tracked.goal).size());
+              });
+    bench.run(std::format("priority_queue+unordered_map/{}x{}", side, side),
+              side * side, 0, [&] {
+                do_not_optimize(
+                    dijkstra_with_maps(grid, start, goal, reindeer));
+              });
+  }
+}
+
+int main(int argc, char **argv) {
+  Microbench bench{std::vector<string>(argv + 1, argv + argc)};
+  if (!check_grid_paths()) {
+    return 1;
+  }
+  bench_split(bench);
+  bench_parse(bench);
+  bench_digits(bench);
+  bench_grid(bench);
+  bench_packed_grid<2>(bench, "XMAS");
+  bench_packed_grid<4>(bench, "0123456789");
+  bench_hash(bench);
+  bench_distinct_pairs(bench);
+  bench_grid_paths(bench);
+  return 0;
+}
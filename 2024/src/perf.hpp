@@ -0,0 +1,258 @@
+#pragma once
+#ifndef PERF_HPP
+#define PERF_HPP
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/types.h>
+
+#ifdef AOC_PERF
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware performance counters via perf_event_open(2). Only compiled in when
+// building with -DAOC_PERF, otherwise everything here is a no-op and the
+// harness prints nothing extra.
+#ifdef AOC_PERF
+constexpr bool perf_enabled = true;
+#else
+constexpr bool perf_enabled = false;
+#endif
+
+enum PerfEvent {
+  PERF_CYCLES,
+  PERF_INSTRUCTIONS,
+  PERF_L1D_MISSES,
+  PERF_LLC_MISSES,
+  PERF_BRANCH_MISSES,
+  NUM_PERF_EVENTS,
+};
+
+// A count of -1 means the event could not be opened (not permitted, not
+// supported by the PMU, or running inside a VM without a virtual PMU).
+struct PerfSample {
+  std::array<int64_t, NUM_PERF_EVENTS> counts;
+
+  PerfSample() { counts.fill(-1); }
+
+  bool available(PerfEvent event) const { return counts[event] >= 0; }
+
+  bool any_available() const {
+    for (const auto count : counts) {
+      if (count >= 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  double ipc() const {
+    if (!available(PERF_CYCLES) || !available(PERF_INSTRUCTIONS) ||
+        counts[PERF_CYCLES] == 0) {
+      return 0.0;
+    }
+    return double(counts[PERF_INSTRUCTIONS]) / double(counts[PERF_CYCLES]);
+  }
+
+  PerfSample &operator+=(const PerfSample &rhs) {
+    for (int i = 0; i < NUM_PERF_EVENTS; ++i) {
+      if (rhs.counts[i] >= 0) {
+        counts[i] = std::max<int64_t>(counts[i], 0) + rhs.counts[i];
+      }
+    }
+    return *this;
+  }
+
+  PerfSample operator-(const PerfSample &rhs) const {
+    PerfSample out;
+    for (int i = 0; i < NUM_PERF_EVENTS; ++i) {
+      if (counts[i] >= 0 && rhs.counts[i] >= 0) {
+        out.counts[i] = counts[i] - rhs.counts[i];
+      }
+    }
+    return out;
+  }
+};
+
+struct PerfCounters {
+  // One set of events per counted thread.
+  std::vector<std::array<int, NUM_PERF_EVENTS>> fds;
+  // Reason the first failing event could not be opened, empty if all opened.
+  std::string error;
+
+  // Counts the given threads, 0 being the calling thread. With inherit set,
+  // threads they spawn after the counters are opened are counted too. Threads
+  // that already exist, like the thread pool workers, have to be listed.
+  explicit PerfCounters(bool inherit = true, std::vector<pid_t> tids = {0}) {
+    fds.resize(tids.size());
+    for (auto &thread_fds : fds) {
+      thread_fds.fill(-1);
+    }
+#ifdef AOC_PERF
+    constexpr auto cache_event = [](uint64_t cache) {
+      return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+             (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    };
+    const std::array<std::pair<uint32_t, uint64_t>, NUM_PERF_EVENTS> events{{
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_L1D)},
+        {PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_LL)},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    }};
+
+    for (size_t t = 0; t < tids.size(); ++t) {
+      for (int i = 0; i < NUM_PERF_EVENTS; ++i) {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = events[i].first;
+        attr.config = events[i].second;
+        attr.disabled = 1;
+        attr.inherit = inherit ? 1 : 0;
+        // User space only so this works with perf_event_paranoid <= 2.
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format =
+            PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        fds[t][i] = syscall(SYS_perf_event_open, &attr, tids[t], -1, -1, 0);
+        if (fds[t][i] < 0 && error.empty()) {
+          error = std::strerror(errno);
+        }
+      }
+    }
+
+    if (!inherit) {
+      // Per-thread counters run continuously and are sampled with read().
+      for_each_fd([](int fd) { ioctl(fd, PERF_EVENT_IOC_ENABLE, 0); });
+    }
+#endif
+  }
+
+  template <typename F> void for_each_fd(F &&f) const {
+    for (const auto &thread_fds : fds) {
+      for (const int fd : thread_fds) {
+        if (fd >= 0) {
+          f(fd);
+        }
+      }
+    }
+  }
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  ~PerfCounters() {
+#ifdef AOC_PERF
+    for_each_fd([](int fd) { close(fd); });
+#endif
+  }
+
+  void start() {
+#ifdef AOC_PERF
+    for_each_fd([](int fd) {
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    });
+#endif
+  }
+
+  // Sums the counts of all threads.
+  PerfSample read() const {
+    PerfSample out;
+#ifdef AOC_PERF
+    for (const auto &thread_fds : fds) {
+      PerfSample thread;
+      for (int i = 0; i < NUM_PERF_EVENTS; ++i) {
+        uint64_t values[3];
+        if (thread_fds[i] < 0 ||
+            ::read(thread_fds[i], values, sizeof(values)) !=
+                ssize_t(sizeof(values))) {
+          continue;
+        }
+        // Scale up when the PMU had to multiplex more events than it has
+        // hardware counters for.
+        auto [value, enabled, running] = values;
+        if (running == 0) {
+          continue;
+        }
+        thread.counts[i] = running < enabled
+                               ? int64_t(double(value) * enabled / running)
+                               : int64_t(value);
+      }
+      out += thread;
+    }
+#endif
+    return out;
+  }
+
+  PerfSample stop() {
+#ifdef AOC_PERF
+    for_each_fd([](int fd) { ioctl(fd, PERF_EVENT_IOC_DISABLE, 0); });
+#endif
+    return read();
+  }
+};
+
+struct PerfPhase {
+  uint64_t calls = 0;
+  PerfSample sample;
+};
+
+inline std::mutex perf_phases_mutex;
+inline std::map<std::string, PerfPhase> perf_phases;
+
+inline void reset_perf_phases() {
+  std::lock_guard lock(perf_phases_mutex);
+  perf_phases.clear();
+}
+
+inline auto take_perf_phases()
+    -> std::vector<std::pair<std::string, PerfPhase>> {
+  std::lock_guard lock(perf_phases_mutex);
+  std::vector<std::pair<std::string, PerfPhase>> out(perf_phases.begin(),
+                                                      perf_phases.end());
+  perf_phases.clear();
+  return out;
+}
+
+// Attributes the counters of the calling thread between construction and
+// destruction to a named phase, e.g. `PerfScope scope("walk");`. Phases are
+// summed over all calls and threads and reported below the part they ran in.
+struct PerfScope {
+#ifdef AOC_PERF
+  const char *name;
+  PerfSample begin;
+
+  static PerfCounters &thread_counters() {
+    thread_local PerfCounters counters(false);
+    return counters;
+  }
+
+  explicit PerfScope(const char *name)
+      : name(name), begin(thread_counters().read()) {}
+
+  ~PerfScope() {
+    PerfSample delta = thread_counters().read() - begin;
+    std::lock_guard lock(perf_phases_mutex);
+    auto &phase = perf_phases[name];
+    ++phase.calls;
+    phase.sample += delta;
+  }
+#else
+  explicit PerfScope(const char *) {}
+#endif
+  PerfScope(const PerfScope &) = delete;
+  PerfScope &operator=(const PerfScope &) = delete;
+};
+#endif // PERF_HPP
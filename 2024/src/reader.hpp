@@ -0,0 +1,382 @@
+#pragma once
+#ifndef READER_HPP
+#define READER_HPP
+// Reads many files at once and hands them out in completion order, so reading
+// the next inputs overlaps solving the current one. Reads are queued through
+// io_uring. Where it is unavailable (old kernels, seccomp filters, or
+// AOC_NO_URING set) a few threads do blocking preads instead.
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+struct FileRead {
+  std::string path;
+  std::string contents;
+  // Empty unless the file could not be read.
+  std::string error;
+};
+
+// Opens the file and sizes `read.contents` for it. Returns the fd, or -1 with
+// read.error set.
+inline int open_for_read(FileRead &read) {
+  const int fd = open(read.path.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) < 0) {
+    read.error = std::strerror(errno);
+    if (fd >= 0) {
+      close(fd);
+    }
+    return -1;
+  }
+  read.contents.resize(st.st_size);
+  return fd;
+}
+
+// Reads the contents from `done` on with blocking reads.
+inline void pread_rest(int fd, FileRead &read, size_t done) {
+  while (done < read.contents.size()) {
+    const ssize_t n = pread(fd, read.contents.data() + done,
+                            read.contents.size() - done, done);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      read.error = std::strerror(errno);
+      return;
+    }
+    if (n == 0) {
+      // Truncated since it was opened.
+      read.contents.resize(done);
+      return;
+    }
+    done += n;
+  }
+}
+
+// The rings io_uring_setup(2) shares with the kernel, mapped by hand since
+// liburing isn't a dependency.
+struct IoUring {
+  int fd = -1;
+  unsigned entries = 0;
+  unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+  unsigned *cq_head, *cq_tail, *cq_mask;
+  io_uring_sqe *sqes = nullptr;
+  io_uring_cqe *cqes;
+  void *sq_ring = MAP_FAILED, *cq_ring = MAP_FAILED;
+  size_t sq_ring_size = 0, cq_ring_size = 0;
+  // Queued but not yet passed to io_uring_enter.
+  unsigned unsubmitted = 0;
+
+  bool setup(unsigned queue_depth) {
+    io_uring_params params{};
+    fd = syscall(__NR_io_uring_setup, queue_depth, &params);
+    if (fd < 0) {
+      return false;
+    }
+    entries = params.sq_entries;
+    sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+      sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+    }
+
+    sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    cq_ring = single_mmap ? sq_ring
+                          : mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_POPULATE, fd,
+                                 IORING_OFF_CQ_RING);
+    void *sqes_map = mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe),
+                          PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          fd, IORING_OFF_SQES);
+    if (sqes_map != MAP_FAILED) {
+      sqes = static_cast<io_uring_sqe *>(sqes_map);
+    }
+    if (sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || !sqes) {
+      return false;
+    }
+
+    auto *sq = static_cast<char *>(sq_ring);
+    auto *cq = static_cast<char *>(cq_ring);
+    sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  ~IoUring() {
+    if (sqes) {
+      munmap(sqes, entries * sizeof(io_uring_sqe));
+    }
+    if (cq_ring != MAP_FAILED && cq_ring != sq_ring) {
+      munmap(cq_ring, cq_ring_size);
+    }
+    if (sq_ring != MAP_FAILED) {
+      munmap(sq_ring, sq_ring_size);
+    }
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+
+  // Queues a read of `len` bytes at `offset`, false if the ring is full.
+  bool queue_read(int file, char *buffer, unsigned len, uint64_t offset,
+                  uint64_t user_data) {
+    const unsigned tail = *sq_tail;
+    if (tail - std::atomic_ref(*sq_head).load(std::memory_order_acquire) >=
+        entries) {
+      return false;
+    }
+    const unsigned index = tail & *sq_mask;
+    io_uring_sqe &sqe = sqes[index];
+    sqe = {};
+    sqe.opcode = IORING_OP_READ;
+    sqe.fd = file;
+    sqe.addr = reinterpret_cast<uint64_t>(buffer);
+    sqe.len = len;
+    sqe.off = offset;
+    sqe.user_data = user_data;
+    sq_array[index] = index;
+    std::atomic_ref(*sq_tail).store(tail + 1, std::memory_order_release);
+    ++unsubmitted;
+    return true;
+  }
+
+  // Submits the queued reads and waits for at least `wait_for` completions.
+  bool enter(unsigned wait_for) {
+    while (true) {
+      const int n = syscall(__NR_io_uring_enter, fd, unsubmitted, wait_for,
+                            wait_for ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+      if (n >= 0) {
+        unsubmitted -= n;
+        return true;
+      }
+      if (errno != EINTR) {
+        return false;
+      }
+    }
+  }
+
+  bool pop(io_uring_cqe &out) {
+    const unsigned head = *cq_head;
+    if (head == std::atomic_ref(*cq_tail).load(std::memory_order_acquire)) {
+      return false;
+    }
+    out = cqes[head & *cq_mask];
+    std::atomic_ref(*cq_head).store(head + 1, std::memory_order_release);
+    return true;
+  }
+};
+
+struct BulkReader {
+  std::vector<std::string> paths;
+  size_t next_path = 0;
+  size_t handed_out = 0;
+
+  IoUring ring;
+  bool use_uring = false;
+  struct InFlight {
+    int fd;
+    size_t done;
+    FileRead read;
+  };
+  // Indexed by the user_data of the reads, reused once a file is done.
+  std::vector<std::optional<InFlight>> in_flight;
+  std::deque<FileRead> completed;
+
+  // The pread workers stop reading ahead once this many files wait to be
+  // handed out, as the ring's size limits the io_uring reads.
+  size_t queue_depth;
+
+  std::mutex mutex;
+  std::condition_variable ready;
+  // Signalled when next() makes room in completed.
+  std::condition_variable space;
+  std::atomic<bool> stopping = false;
+  // Last so they are joined before the state they use is destroyed.
+  std::vector<std::jthread> workers;
+
+  explicit BulkReader(std::vector<std::string> paths, size_t queue_depth = 64)
+      : paths(std::move(paths)), queue_depth(queue_depth) {
+    if (!std::getenv("AOC_NO_URING") && ring.setup(queue_depth)) {
+      use_uring = true;
+      in_flight.resize(ring.entries);
+      return;
+    }
+    const size_t num_workers = std::min<size_t>(4, this->paths.size());
+    for (size_t i = 0; i < num_workers; ++i) {
+      workers.emplace_back([this] { pread_worker(); });
+    }
+  }
+
+  ~BulkReader() {
+    {
+      std::lock_guard lock(mutex);
+      stopping = true;
+    }
+    space.notify_all();
+    // The kernel may still be writing into the buffers of reads in flight.
+    io_uring_cqe cqe;
+    while (reading() && ring.enter(1)) {
+      while (ring.pop(cqe)) {
+        close(in_flight[cqe.user_data]->fd);
+        in_flight[cqe.user_data].reset();
+      }
+    }
+  }
+
+  bool reading() const {
+    return std::ranges::any_of(
+        in_flight, [](const auto &slot) { return slot.has_value(); });
+  }
+
+  const char *backend() const { return use_uring ? "io_uring" : "pread"; }
+
+  // The next file to finish reading, nullopt once every file was returned.
+  std::optional<FileRead> next() {
+    if (handed_out == paths.size()) {
+      return std::nullopt;
+    }
+    ++handed_out;
+    if (use_uring) {
+      while (completed.empty()) {
+        reap();
+      }
+    } else {
+      std::unique_lock lock(mutex);
+      ready.wait(lock, [&] { return !completed.empty(); });
+    }
+    FileRead read;
+    {
+      std::lock_guard lock(mutex);
+      read = std::move(completed.front());
+      completed.pop_front();
+    }
+    space.notify_one();
+    return read;
+  }
+
+  void pread_worker() {
+    while (!stopping) {
+      const size_t index = std::atomic_ref(next_path).fetch_add(1);
+      if (index >= paths.size()) {
+        return;
+      }
+      FileRead read{paths[index]};
+      if (const int fd = open_for_read(read); fd >= 0) {
+        pread_rest(fd, read, 0);
+        close(fd);
+      }
+      {
+        std::unique_lock lock(mutex);
+        space.wait(lock,
+                   [&] { return stopping || completed.size() < queue_depth; });
+        if (stopping) {
+          return;
+        }
+        completed.push_back(std::move(read));
+      }
+      ready.notify_one();
+    }
+  }
+
+  void queue_rest(size_t slot) {
+    auto &file = *in_flight[slot];
+    // A read can't be longer than an unsigned, so big files take several.
+    const size_t len =
+        std::min<size_t>(file.read.contents.size() - file.done, 1u << 30);
+    ring.queue_read(file.fd, file.read.contents.data() + file.done, len,
+                    file.done, slot);
+  }
+
+  void finish(size_t slot) {
+    auto &file = *in_flight[slot];
+    close(file.fd);
+    completed.push_back(std::move(file.read));
+    in_flight[slot].reset();
+  }
+
+  // Fills the ring with new files, then waits for and handles completions.
+  void reap() {
+    for (size_t slot = 0; slot < in_flight.size() && next_path < paths.size();
+         ++slot) {
+      if (in_flight[slot]) {
+        continue;
+      }
+      FileRead read{paths[next_path++]};
+      const int fd = open_for_read(read);
+      if (fd < 0) {
+        completed.push_back(std::move(read));
+        continue;
+      }
+      in_flight[slot] = InFlight{fd, 0, std::move(read)};
+      if (in_flight[slot]->read.contents.empty()) {
+        finish(slot);
+      } else {
+        queue_rest(slot);
+      }
+    }
+
+    if (!reading()) {
+      return;
+    }
+    if (!ring.enter(completed.empty() ? 1 : 0)) {
+      // Finish whatever is left with blocking reads.
+      for (size_t slot = 0; slot < in_flight.size(); ++slot) {
+        if (in_flight[slot]) {
+          pread_rest(in_flight[slot]->fd, in_flight[slot]->read,
+                     in_flight[slot]->done);
+          finish(slot);
+        }
+      }
+      return;
+    }
+
+    io_uring_cqe cqe;
+    while (ring.pop(cqe)) {
+      const size_t slot = cqe.user_data;
+      auto &file = *in_flight[slot];
+      if (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP) {
+        // Kernels before 5.6 don't know IORING_OP_READ.
+        pread_rest(file.fd, file.read, file.done);
+        finish(slot);
+      } else if (cqe.res < 0) {
+        file.read.error = std::strerror(-cqe.res);
+        finish(slot);
+      } else if (cqe.res == 0) {
+        // Truncated since it was opened.
+        file.read.contents.resize(file.done);
+        finish(slot);
+      } else if (file.done + cqe.res == file.read.contents.size()) {
+        finish(slot);
+      } else {
+        file.done += cqe.res;
+        queue_rest(slot);
+      }
+    }
+  }
+};
+#endif // READER_HPP
@@ -20,8 +20,11 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE
  */
+#include <algorithm>
+#include <cmath>
 #include <iterator>
 #include <utility>
+#include <vector>
 
 template <typename Iterator> struct distinct_pairs_iterator {
   typedef
@@ -93,6 +96,8 @@ template <typename Iterator> struct distinct_pairs_iterator {
   }
 
   distinct_pairs_iterator<Iterator> &operator+=(difference_type offset) {
+    if (offset == 0)
+      return *this;
     difference_type N = std::distance(range.first, range.second);
     difference_type k = index(N) + offset;
     difference_type i = index_i(k, N);
@@ -177,14 +182,23 @@ protected:
     return j - i + (i * (2 * N - (i + 1))) / 2 - 1;
   }
 
+  // The row of the k-th pair. Rows before i hold i * (2N - i - 1) / 2 pairs,
+  // so solving that for k gives i in O(1), up to rounding in the square root
+  // which the loops correct.
   difference_type index_i(difference_type k, difference_type N) const {
-    difference_type d = N, total = 0;
-    for (difference_type a = 0; a < N; ++a) {
-      total += --d;
-      if (total > k)
-        return a;
-    }
-    return N - 1;
+    const auto before = [N](difference_type i) {
+      return (i * (2 * N - (i + 1))) / 2;
+    };
+    const double b = 2.0 * double(N) - 1.0;
+    difference_type i = static_cast<difference_type>(
+        std::floor((b - std::sqrt(std::max(0.0, b * b - 8.0 * double(k)))) /
+                   2.0));
+    i = std::min(i, N - 1);
+    while (i > 0 && before(i) > k)
+      --i;
+    while (i + 1 < N && before(i + 1) <= k)
+      ++i;
+    return i;
   }
 
   difference_type index_j(difference_type k, difference_type i,
@@ -222,6 +236,22 @@ template <typename Iterator> struct distinct_pairs_range {
     return iterator(range, temp);
   }
 
+  // The pairs in `parts` runs of consecutive pairs, as (begin, end), whose
+  // sizes differ by at most one, e.g. to hand to threads.
+  std::vector<std::pair<iterator, iterator>>
+  split(difference_type parts) const {
+    std::vector<std::pair<iterator, iterator>> out;
+    const difference_type n = size();
+    const iterator first = begin();
+    iterator last = first;
+    for (difference_type p = 0; p < parts; ++p) {
+      iterator next = p + 1 == parts ? end() : first + n * (p + 1) / parts;
+      out.emplace_back(last, next);
+      last = next;
+    }
+    return out;
+  }
+
 protected:
   pair_type range;
 };
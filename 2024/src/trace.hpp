@@ -0,0 +1,170 @@
+#pragma once
+#ifndef TRACE_HPP
+#define TRACE_HPP
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <string>
+#include <vector>
+
+// Scoped timeline tracing, compiled in only when building with -DAOC_TRACE.
+// Mark a phase with `TraceScope scope("walk");`; nested scopes and scopes on
+// worker threads all end up in a Chrome trace written to trace.json (or
+// $AOC_TRACE_FILE) at exit, and after every input in batch mode, viewable in
+// chrome://tracing or ui.perfetto.dev.
+#ifdef AOC_TRACE
+constexpr bool trace_enabled = true;
+#else
+constexpr bool trace_enabled = false;
+#endif
+
+struct TraceEvent {
+  const char *name;
+  int64_t begin_ns, end_ns;
+};
+
+// Each thread only ever appends to its own buffer, so recording takes no lock.
+// The session owns the buffers so they outlive the pool workers that fill
+// them.
+struct TraceBuffer {
+  int tid;
+  std::vector<TraceEvent> events;
+};
+
+struct TraceSession {
+  std::chrono::steady_clock::time_point epoch =
+      std::chrono::steady_clock::now();
+  std::mutex buffers_mutex;
+  std::vector<std::unique_ptr<TraceBuffer>> buffers;
+  // The trace file, opened by the first flush().
+  std::ofstream out;
+  bool failed = false;
+  bool first_event = true;
+  // How many threads the file names so far.
+  size_t named = 0;
+
+  int64_t now_ns() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - epoch)
+        .count();
+  }
+
+  // Only takes the lock the first time a thread records something.
+  TraceBuffer &thread_buffer() {
+    thread_local TraceBuffer *buffer = nullptr;
+    if (buffer == nullptr) {
+      std::lock_guard lock(buffers_mutex);
+      buffers.push_back(std::make_unique<TraceBuffer>());
+      buffer = buffers.back().get();
+      buffer->tid = buffers.size() - 1;
+      buffer->events.reserve(4096);
+    }
+    return *buffer;
+  }
+
+  // Appends the events recorded so far to the trace file and empties the
+  // buffers, so batch and server runs don't keep every event until exit.
+  // Only call it while no other thread is recording, e.g. between solves.
+  void flush() {
+    if constexpr (!trace_enabled) {
+      return;
+    }
+    std::lock_guard lock(buffers_mutex);
+    if (!out.is_open() && !failed) {
+      const char *path = std::getenv("AOC_TRACE_FILE");
+      out.open(path ? path : "trace.json");
+      if (!out) {
+        std::println(stderr, "Failed to write trace to {}",
+                     path ? path : "trace.json");
+        failed = true;
+      } else {
+        std::print(out, "{{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+      }
+    }
+
+    for (; !failed && named < buffers.size(); ++named) {
+      const int tid = buffers[named]->tid;
+      std::print(out,
+                 "{}{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                 "\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}",
+                 separator(), tid,
+                 tid == 0 ? std::string("main")
+                          : "worker " + std::to_string(tid));
+    }
+    for (const auto &buffer : buffers) {
+      for (const auto &event : buffer->events) {
+        if (failed) {
+          break;
+        }
+        std::print(out,
+                   "{}{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},"
+                   "\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                   separator(), escape(event.name), buffer->tid,
+                   event.begin_ns / 1000.0,
+                   (event.end_ns - event.begin_ns) / 1000.0);
+      }
+      buffer->events.clear();
+    }
+    if (!failed) {
+      out.flush();
+    }
+  }
+
+  const char *separator() {
+    const char *out = first_event ? "" : ",";
+    first_event = false;
+    return out;
+  }
+
+  static std::string escape(const char *name) {
+    std::string out;
+    for (const char *c = name; *c; ++c) {
+      if (*c == '"' || *c == '\\') {
+        out.push_back('\\');
+      }
+      out.push_back(*c);
+    }
+    return out;
+  }
+
+  ~TraceSession() {
+    if constexpr (trace_enabled) {
+      flush();
+      if (out.is_open()) {
+        std::println(out, "]}}");
+      }
+    }
+  }
+};
+
+inline TraceSession trace_session;
+
+// Records the lifetime of the scope as a complete event on the calling
+// thread's timeline. The name must outlive the process (use a literal).
+struct TraceScope {
+#ifdef AOC_TRACE
+  TraceBuffer &buffer;
+  const char *name;
+  int64_t begin_ns;
+
+  explicit TraceScope(const char *name)
+      : buffer(trace_session.thread_buffer()), name(name),
+        begin_ns(trace_session.now_ns()) {}
+
+  ~TraceScope() {
+    // Appended on close, so nested scopes land before their parent; viewers
+    // sort by timestamp anyway.
+    buffer.events.push_back({name, begin_ns, trace_session.now_ns()});
+  }
+#else
+  explicit TraceScope(const char *) {}
+#endif
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+};
+#endif // TRACE_HPP
@@ -1,17 +1,50 @@
 #pragma once
 #ifndef UTIL_HPP
 #define UTIL_HPP
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <charconv>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <expected>
+#include <format>
+#include <functional>
 #include <future>
+#include <iostream>
+#include <latch>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <optional>
+#include <print>
 #include <ranges>
+#include <span>
 #include <sstream>
+#include <stdexcept>
+#include <string>
 #include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include <unistd.h>
+
+#include "alloc.hpp"
+#include "arena.hpp"
+#include "batch.hpp"
+#include "hash.hpp"
+#include "perf.hpp"
+#include "trace.hpp"
+
 namespace parse {
 constexpr auto to_string(const std::string_view &sv)
     -> std::optional<std::string> {
@@ -47,13 +80,10 @@ constexpr auto to_uint64(const std::string_view &sv)
 }
 } // namespace parse
 
-template <typename Parser>
-auto split(const std::string &s, const char delimiter,
-           Parser parser = parse::to_string)
-    -> std::vector<
-        typename std::invoke_result_t<Parser, std::string_view>::value_type> {
-  using T = typename std::invoke_result_t<Parser, std::string_view>::value_type;
-  std::vector<T> result;
+// Appends the tokens the parser accepts to result.
+template <typename Vector, typename Parser>
+constexpr void split_into(Vector &result, std::string_view s,
+                          const char delimiter, Parser parser) {
   for (const auto &token : std::views::split(s, delimiter) |
                                std::views::transform([&](auto &&token) {
                                  return std::string_view(token.begin(),
@@ -63,9 +93,42 @@ auto split(const std::string &s, const char delimiter,
       result.push_back(*parsed);
     }
   }
+}
+
+template <typename Parser>
+constexpr auto split(std::string_view s, const char delimiter,
+                     Parser parser = parse::to_string)
+    -> std::vector<
+        typename std::invoke_result_t<Parser, std::string_view>::value_type> {
+  using T = typename std::invoke_result_t<Parser, std::string_view>::value_type;
+  std::vector<T> result;
+  split_into(result, s, delimiter, parser);
   return result;
 }
 
+// split() into a vector from the resource, e.g. scratch_resource().
+template <typename Parser>
+auto split(std::string_view s, const char delimiter, Parser parser,
+           std::pmr::memory_resource *resource)
+    -> std::pmr::vector<
+        typename std::invoke_result_t<Parser, std::string_view>::value_type> {
+  using T = typename std::invoke_result_t<Parser, std::string_view>::value_type;
+  std::pmr::vector<T> result(resource);
+  split_into(result, s, delimiter, parser);
+  return result;
+}
+
+// The non-empty lines of the input. Unlike getline() on an istringstream it
+// doesn't copy them, and it works in constant expressions.
+constexpr auto split_lines(std::string_view input) {
+  return input | std::views::split('\n') |
+         std::views::transform([](auto &&line) {
+           return std::string_view(line.begin(), line.end());
+         }) |
+         std::views::filter(
+             [](std::string_view line) { return !line.empty(); });
+}
+
 template <typename T>
 std::string join(const std::vector<T> &vec, std::string delimiter) {
   std::ostringstream s("");
@@ -78,35 +141,63 @@ std::string join(const std::vector<T> &vec, std::string delimiter) {
   return s.str();
 }
 
-inline uint64_t concatenate(uint64_t x, uint64_t y) {
+// 10^0 to 10^20, the last wrapped mod 2^64 as it doesn't fit, so that
+// concatenate() wraps like other uint64_t arithmetic on overflow.
+constexpr auto POW10 = [] {
+  std::array<uint64_t, 21> out{};
   uint64_t pow10 = 1;
-  while (pow10 <= y) {
+  for (auto &value : out) {
+    value = pow10;
     pow10 *= 10;
   }
-  return x * pow10 + y;
+  return out;
+}();
+
+// The number of digits of x, none for 0. Its bit width gives that to within
+// one, bits * log10(2) being about bits * 1233 / 4096, and one comparison with
+// the table settles which.
+constexpr int count_digits(uint64_t x) {
+  const int guess = std::bit_width(x) * 1233 >> 12;
+  return guess + (x >= POW10[guess]);
 }
 
-template <typename T> inline int get_num_digits(T x) {
-  uint64_t pow10 = 10;
-  int num_digits = 1;
-  while (pow10 <= x) {
-    pow10 *= 10;
-    ++num_digits;
+// The smallest power of 10 above x, which appending x to a number multiplies
+// it by. That is 1 for 0, so appending 0 leaves a number as is.
+constexpr uint64_t pow10_above(uint64_t x) { return POW10[count_digits(x)]; }
+
+constexpr uint64_t concatenate(uint64_t x, uint64_t y) {
+  return x * pow10_above(y) + y;
+}
+
+// concatenate(), or nothing if the result doesn't fit in 64 bits.
+constexpr std::optional<uint64_t> checked_concatenate(uint64_t x, uint64_t y) {
+  const int digits = count_digits(y);
+  uint64_t out;
+  if ((digits >= 20 && x != 0) ||
+      __builtin_mul_overflow(x, POW10[digits], &out) ||
+      __builtin_add_overflow(out, y, &out)) {
+    return std::nullopt;
   }
-  return num_digits;
+  return out;
+}
+
+// 0 has one digit.
+template <typename T> constexpr int get_num_digits(T x) {
+  return count_digits(uint64_t(x) | 1);
 }
 
 // index determines the last digit in the left number, starting at 0 for the
-// right-most digit in x.
-template <typename T> inline std::pair<T, T> split_number(T x, int index) {
-  int v = pow(10, index);
-  auto left = x / v;
-  auto right = x % v;
-  return std::make_pair(left, right);
+// right-most digit in x. It can be at most 19.
+template <typename T>
+constexpr std::pair<T, T> split_number(T x, int index) {
+  const uint64_t pow10 = POW10[index];
+  return std::make_pair(T(uint64_t(x) / pow10), T(uint64_t(x) % pow10));
 }
 
-template <typename T, typename Batch>
-concept InputProvider = requires(T t, Batch b, const std::string &input) {
+// Input is what prepare() gets: the input text, or what a day's parse_input()
+// made of it.
+template <typename T, typename Batch, typename Input = std::string>
+concept InputProvider = requires(T t, Batch b, const Input &input) {
   { t.prepare(input) };
   { t.provide() } -> std::same_as<Batch>;
   { t.done() } -> std::same_as<bool>;
@@ -118,36 +209,216 @@ concept InputConsumer = requires(T t, Batch input, BatchResult output) {
 };
 
 template <typename T, typename Batch, typename BatchResult,
-          typename FinalResult>
+          typename FinalResult, typename Input = std::string>
 concept Multithreader =
     requires(T t, BatchResult batchResult, FinalResult finalResult) {
-      { t.provider } -> InputProvider<Batch>;
+      { t.provider } -> InputProvider<Batch, Input>;
       { t.consumer } -> InputConsumer<Batch, BatchResult>;
-      { t.combine(finalResult, batchResult) } -> std::same_as<FinalResult>;
+      {
+        t.combine(std::move(finalResult), std::move(batchResult))
+      } -> std::same_as<FinalResult>;
     };
 
-template <typename Batch, typename BatchResult, typename FinalResult>
-FinalResult execute(const std::string &input,
-                    Multithreader<Batch, BatchResult, FinalResult> auto &m,
-                    FinalResult starting_value) {
-  m.provider.prepare(input);
+// Workers shared by every execute() in the process. They are started once, so
+// solving many inputs in one process (batch mode) doesn't pay for creating
+// threads on every solve like std::async did.
+struct ThreadPool {
+  std::mutex mutex;
+  std::condition_variable available;
+  std::deque<std::function<void()>> tasks;
+  std::vector<std::thread> workers;
+  std::vector<pid_t> worker_tids;
+  bool stopping = false;
+
+  explicit ThreadPool(size_t num_threads) : worker_tids(num_threads) {
+    std::latch started(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+      workers.emplace_back([this, i, &started] {
+        worker_tids[i] = gettid();
+        started.count_down();
+        work();
+      });
+    }
+    // The tids are needed to count the workers with perf.
+    started.wait();
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard lock(mutex);
+      stopping = true;
+    }
+    available.notify_all();
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+  void work() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock lock(mutex);
+        available.wait(lock, [&] { return stopping || !tasks.empty(); });
+        if (tasks.empty()) {
+          return;
+        }
+        task = std::move(tasks.front());
+        tasks.pop_front();
+      }
+      task();
+    }
+  }
+
+  template <typename F>
+  auto submit(F &&f) -> std::future<std::invoke_result_t<F>> {
+    using Result = std::invoke_result_t<F>;
+    // std::function needs something copyable, a packaged_task isn't.
+    auto task =
+        std::make_shared<std::packaged_task<Result()>>(std::forward<F>(f));
+    auto future = task->get_future();
+    {
+      std::lock_guard lock(mutex);
+      tasks.emplace_back([task] { (*task)(); });
+    }
+    available.notify_one();
+    return future;
+  }
+
+  // Runs one queued task on the calling thread, if there is one.
+  bool run_one() {
+    std::function<void()> task;
+    {
+      std::lock_guard lock(mutex);
+      if (tasks.empty()) {
+        return false;
+      }
+      task = std::move(tasks.front());
+      tasks.pop_front();
+    }
+    task();
+    return true;
+  }
+
+  // Helps with the queue while waiting so a task waiting on tasks it
+  // submitted can't deadlock the pool. Once the queue is empty, everything
+  // the future depends on is already running.
+  template <typename T> T get(std::future<T> &future) {
+    while (future.wait_for(std::chrono::seconds(0)) !=
+           std::future_status::ready) {
+      if (!run_one()) {
+        future.wait();
+      }
+    }
+    return future.get();
+  }
+};
+
+// One worker per hardware thread unless AOC_THREADS says otherwise.
+inline ThreadPool &thread_pool() {
+  static ThreadPool pool([] {
+    if (const char *threads = std::getenv("AOC_THREADS")) {
+      if (auto n = parse::to_int(threads); n && *n > 0) {
+        return size_t(*n);
+      }
+    }
+    return size_t(std::max(1u, std::thread::hardware_concurrency()));
+  }());
+  return pool;
+}
+
+template <typename Batch, typename BatchResult, typename FinalResult,
+          typename Input>
+FinalResult
+execute(const Input &input,
+        Multithreader<Batch, BatchResult, FinalResult, Input> auto &m,
+        FinalResult starting_value) {
+  {
+    TraceScope scope("prepare");
+    m.provider.prepare(input);
+  }
+  auto &pool = thread_pool();
   std::vector<std::future<BatchResult>> futures;
   while (!m.provider.done()) {
-    Batch batch = m.provider.provide();
-    futures.push_back(std::async(
-        std::launch::async,
-        [&](Batch batch) { return m.consumer.consume(batch); }, batch));
+    TraceScope scope("provide");
+    futures.push_back(
+        pool.submit([&m, batch = m.provider.provide()]() mutable {
+          TraceScope scope("consume");
+          // What the consumer took from scratch_resource() is released after
+          // each batch, so the result must not live there.
+          ScratchScope scratch;
+          return m.consumer.consume(std::move(batch));
+        }));
   }
 
-  FinalResult result = starting_value;
+  // Moved through combine(), so one that updates its accumulator in place
+  // never copies it.
+  TraceScope scope("combine");
+  FinalResult result = std::move(starting_value);
   for (auto &future : futures) {
-    BatchResult batch_result = future.get();
-    result = m.combine(result, batch_result);
+    BatchResult batch_result = pool.get(future);
+    result = m.combine(std::move(result), std::move(batch_result));
   }
 
   return result;
 }
 
+// Rows [begin, end) of a grid that one band owns, and the rows it may read,
+// the halo rows around them [read_begin, read_end) included.
+struct RowBand {
+  size_t begin, end;
+  size_t read_begin, read_end;
+};
+
+// Splits the rows of a grid into bands and runs fn(band) for each on the
+// thread pool, then folds what they return with reduce, in order. Unlike
+// execute() the grid is shared, so a band reads its halo in place, and
+// whatever fn builds per row from its read rows (masks, say) is built for the
+// halo rows again by the neighboring bands.
+template <typename Grid, typename F, typename Reduce = std::plus<>>
+auto parallel_for_rows(const Grid &grid, size_t halo, F &&fn,
+                       Reduce reduce = {}) {
+  using Result = std::invoke_result_t<F &, const RowBand &>;
+  auto &pool = thread_pool();
+  // A few bands per thread so uneven ones even out, but not so thin that
+  // their halos are most of the work.
+  const size_t min_rows = std::max<size_t>(16, 4 * halo);
+  const size_t bands = std::clamp<size_t>(grid.height / min_rows, 1,
+                                          4 * pool.workers.size());
+  std::vector<std::future<Result>> futures;
+  for (size_t i = 0; i < bands; ++i) {
+    RowBand band;
+    band.begin = grid.height * i / bands;
+    band.end = grid.height * (i + 1) / bands;
+    band.read_begin = band.begin - std::min(band.begin, halo);
+    band.read_end = std::min(grid.height, band.end + halo);
+    futures.push_back(pool.submit([&fn, band] {
+      TraceScope scope("band");
+      return fn(band);
+    }));
+  }
+
+  // Every band has to finish before returning, even after one threw, since
+  // they all use fn.
+  std::optional<Result> result;
+  std::exception_ptr error;
+  for (auto &future : futures) {
+    try {
+      Result value = pool.get(future);
+      result = result ? reduce(std::move(*result), std::move(value))
+                      : std::move(value);
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  return std::move(*result);
+}
+
 auto time_start = std::chrono::high_resolution_clock::now();
 
 inline void reset_timer() {
@@ -160,6 +431,735 @@ inline auto get_timer_microseconds() {
       .count();
 }
 
+struct Measurement {
+  int64_t microseconds;
+  PerfSample perf;
+  std::string perf_error;
+  std::vector<std::pair<std::string, PerfPhase>> phases;
+  AllocReport alloc;
+};
+
+template <typename AnswerType> struct PartReport {
+  AnswerType answer;
+  Measurement measurement;
+};
+
+// Runs f with its logs under a header, timing it (and counting it when built
+// with -DAOC_PERF or -DAOC_ALLOC).
+template <typename F>
+auto measure(const char *header, const char *trace_name, F &&f)
+    -> std::pair<std::invoke_result_t<F>, Measurement> {
+  std::println(std::cout, " --- {} LOGS ---", header);
+  // The pool workers outlive the part, so they are counted by tid rather than
+  // through inheritance.
+  std::vector<pid_t> tids{0};
+  std::ranges::copy(thread_pool().worker_tids, std::back_inserter(tids));
+  PerfCounters counters(true, tids);
+  reset_perf_phases();
+  reset_alloc_stats();
+  counters.start();
+  reset_timer();
+  auto result = [&] {
+    TraceScope scope(trace_name);
+    return f();
+  }();
+  Measurement measurement{get_timer_microseconds()};
+  measurement.perf = counters.stop();
+  measurement.perf_error = counters.error;
+  measurement.phases = take_perf_phases();
+  measurement.alloc = take_alloc_report();
+  std::println(std::cout);
+  std::println(std::cout);
+  return {std::move(result), std::move(measurement)};
+}
+
+template <typename AnswerType>
+using BoundPart = std::function<std::expected<AnswerType, std::string>()>;
+
+// What solve_both() returns: the answers of both parts from one pass.
+template <typename AnswerType>
+using BothAnswers =
+    std::expected<std::pair<AnswerType, AnswerType>, std::string>;
+
+template <typename AnswerType>
+using BoundBoth = std::function<BothAnswers<AnswerType>()>;
+
+// Errors are printed and reported as a 0 answer.
+template <typename AnswerType>
+AnswerType
+answer_or_zero(const std::expected<AnswerType, std::string> &answer) {
+  if (!answer) {
+    std::println(std::cout, "\033[1;31m{}\033[0m", answer.error());
+    return 0;
+  }
+  return *answer;
+}
+
+// Runs one part under measure().
+template <typename AnswerType>
+PartReport<AnswerType> run_part(int part, const BoundPart<AnswerType> &solve) {
+  auto [answer, measurement] =
+      measure(part == 1 ? "PART 1" : "PART 2",
+              part == 1 ? "part_one" : "part_two",
+              [&] { return answer_or_zero(solve()); });
+  return {answer, std::move(measurement)};
+}
+
+// Runs solve_both() under measure(), like run_part().
+template <typename AnswerType>
+std::pair<std::pair<AnswerType, AnswerType>, Measurement>
+run_both(const BoundBoth<AnswerType> &solve_both) {
+  return measure("PARTS 1 AND 2", "solve_both", [&] {
+    return solve_both()
+        .or_else([](std::string error) {
+          std::println(std::cout, "\033[1;31m{}\033[0m", error);
+          return BothAnswers<AnswerType>(std::pair<AnswerType, AnswerType>());
+        })
+        .value();
+  });
+}
+
+inline std::string format_perf_count(const PerfSample &sample,
+                                     PerfEvent event) {
+  return sample.available(event) ? std::format("{}", sample.counts[event])
+                                 : std::string("n/a");
+}
+
+inline void print_perf_sample(const std::string &indent,
+                              const PerfSample &sample) {
+  std::println(std::cout, "{}Cycles: {} Instructions: {} IPC: {:.2f}", indent,
+               format_perf_count(sample, PERF_CYCLES),
+               format_perf_count(sample, PERF_INSTRUCTIONS), sample.ipc());
+  std::println(std::cout, "{}L1d misses: {} LLC misses: {} Branch misses: {}",
+               indent, format_perf_count(sample, PERF_L1D_MISSES),
+               format_perf_count(sample, PERF_LLC_MISSES),
+               format_perf_count(sample, PERF_BRANCH_MISSES));
+}
+
+inline void print_took(int64_t microseconds) {
+  std::println(std::cout, "\t\tTook {} us ({} ms) ({} s)", microseconds,
+               float(microseconds) / 1000.0, float(microseconds) / 1000000.0);
+}
+
+inline void print_measurement(const Measurement &measurement) {
+  print_took(measurement.microseconds);
+  if constexpr (perf_enabled) {
+    if (!measurement.perf.any_available()) {
+      std::println(std::cout, "\t\tPerf counters unavailable ({})",
+                   measurement.perf_error);
+    } else {
+      print_perf_sample("\t\t", measurement.perf);
+      for (const auto &[name, phase] : measurement.phases) {
+        std::println(std::cout, "\t\t[{}] x{}", name, phase.calls);
+        print_perf_sample("\t\t\t", phase.sample);
+      }
+    }
+  }
+  if constexpr (alloc_enabled) {
+    const auto &alloc = measurement.alloc;
+    std::println(std::cout,
+                 "\t\tAllocations: {} ({} bytes) Peak live: {} bytes Peak "
+                 "RSS: {} KiB",
+                 alloc.total.allocations, alloc.total.bytes,
+                 alloc.total.peak_live, alloc.peak_rss_kib);
+    for (const auto &thread : alloc.threads) {
+      std::println(std::cout,
+                   "\t\t\tThread {}: {} allocations ({} bytes) Peak live: {} "
+                   "bytes",
+                   thread.thread, thread.allocations, thread.bytes,
+                   thread.peak_live);
+    }
+  }
+}
+
+template <typename AnswerType>
+void print_part_report(int part, const PartReport<AnswerType> &report) {
+  std::println(std::cout, "\tPart {}", part);
+  std::println(std::cout, "\t\tAnswer: {}", report.answer);
+  print_measurement(report.measurement);
+}
+
+template <typename AnswerType>
+using PartFunction = std::function<std::expected<AnswerType, std::string>(
+    const std::string &)>;
+
+// An alternative implementation of a part, e.g. the slow but obviously correct
+// version an optimized part replaced. diff.sh checks that they all agree.
+template <typename AnswerType> struct Variant {
+  int part;
+  std::string name;
+  PartFunction<AnswerType> solve;
+};
+
+template <typename T> struct unwrap_expected {
+  using type = T;
+};
+
+template <typename T, typename E>
+struct unwrap_expected<std::expected<T, E>> {
+  using type = T;
+};
+
+// What a day's parse_input() returns, which may or may not be wrapped in an
+// expected depending on whether parsing can fail.
+template <typename Parse>
+using parsed_type = typename unwrap_expected<
+    std::invoke_result_t<Parse, std::string_view>>::type;
+
+// A day's parts bound to one parsed input.
+template <typename AnswerType> struct ParsedInput {
+  BoundPart<AnswerType> part_one, part_two;
+  // Empty unless the day has solve_both().
+  BoundBoth<AnswerType> both;
+
+  const BoundPart<AnswerType> &part(int n) const {
+    return n == 1 ? part_one : part_two;
+  }
+};
+
+// Everything the harness needs to know about a day.
+template <typename AnswerType> struct Day {
+  int number;
+  // Whether the day has a parse_input() shared by both parts. Days whose
+  // parts take the input text parse inside each part.
+  bool parses;
+  // The parts bound to an input. Those of days without parse_input() refer
+  // to the input, which has to outlive them.
+  std::function<std::expected<ParsedInput<AnswerType>, std::string>(
+      const std::string &)>
+      parse;
+  std::vector<Variant<AnswerType>> variants;
+};
+
+// solve_both is empty for days without one.
+template <typename AnswerType>
+Day<AnswerType>
+make_day(int number, PartFunction<AnswerType> part_one,
+         PartFunction<AnswerType> part_two,
+         std::function<BothAnswers<AnswerType>(const std::string &)> solve_both,
+         std::vector<Variant<AnswerType>> variants) {
+  return {number, false,
+          [=](const std::string &input)
+              -> std::expected<ParsedInput<AnswerType>, std::string> {
+            ParsedInput<AnswerType> parsed{
+                [&input, part_one] { return part_one(input); },
+                [&input, part_two] { return part_two(input); }};
+            if (solve_both) {
+              parsed.both = [&input, solve_both] { return solve_both(input); };
+            }
+            return parsed;
+          },
+          std::move(variants)};
+}
+
+// solve_both is nullptr for days without one.
+template <typename AnswerType, typename Parse, typename PartOne,
+          typename PartTwo, typename SolveBoth>
+Day<AnswerType> make_day(int number, Parse parse_input, PartOne part_one,
+                         PartTwo part_two, SolveBoth solve_both,
+                         std::vector<Variant<AnswerType>> variants) {
+  using Parsed = parsed_type<Parse>;
+  return {number, true,
+          [=](const std::string &input)
+              -> std::expected<ParsedInput<AnswerType>, std::string> {
+            std::expected<Parsed, std::string> parsed = parse_input(input);
+            if (!parsed) {
+              return std::unexpected(parsed.error());
+            }
+            // Shared so the bound parts can be copied.
+            auto shared = std::make_shared<const Parsed>(std::move(*parsed));
+            ParsedInput<AnswerType> bound{
+                [shared, part_one] { return part_one(*shared); },
+                [shared, part_two] { return part_two(*shared); }};
+            if constexpr (!std::is_null_pointer_v<SolveBoth>) {
+              bound.both = [shared, solve_both] {
+                return solve_both(*shared);
+              };
+            }
+            return bound;
+          },
+          std::move(variants)};
+}
+
+// Turns a part of a day with parse_input() into a Variant's function, which
+// takes the input text.
+template <typename AnswerType, typename Parse, typename Part>
+PartFunction<AnswerType> parsed_part(Parse parse_input, Part part) {
+  return [=](const std::string &input)
+             -> std::expected<AnswerType, std::string> {
+    std::expected<parsed_type<Parse>, std::string> parsed = parse_input(input);
+    if (!parsed) {
+      return std::unexpected(parsed.error());
+    }
+    return part(*parsed);
+  };
+}
+
+template <typename AnswerType>
+std::string
+format_answer(const std::expected<AnswerType, std::string> &answer) {
+  return answer ? std::format("{}", *answer)
+                : std::format("error: {}", answer.error());
+}
+
+inline int64_t
+microseconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Runs every implementation of each part on the input, including
+// solve_both(), and reports where they disagree with the main one. Returns 1
+// on any disagreement, and NOTHING_TO_COMPARE when the day has nothing to
+// compare its parts with, so that doesn't pass for agreement.
+constexpr int NOTHING_TO_COMPARE = 2;
+
+template <typename AnswerType>
+int run_diff(const Day<AnswerType> &day, const std::string &input) {
+  const auto parsed = day.parse(input);
+  const bool has_both = parsed && parsed->both;
+  if (day.variants.empty() && !has_both) {
+    std::println(std::cerr, "No variants registered, nothing to compare");
+    return NOTHING_TO_COMPARE;
+  }
+
+  BothAnswers<AnswerType> both = std::unexpected("");
+  if (has_both) {
+    both = parsed->both();
+  }
+  int result = 0;
+  auto compare = [&](int part, const std::string &name,
+                     const std::expected<AnswerType, std::string> &expected,
+                     const std::expected<AnswerType, std::string> &actual) {
+    if (actual != expected) {
+      std::println(std::cout, "Part {}: main = {}, {} = {}", part,
+                   format_answer(expected), name, format_answer(actual));
+      result = 1;
+    }
+  };
+  for (const int part : {1, 2}) {
+    std::expected<AnswerType, std::string> expected =
+        std::unexpected(parsed ? "" : parsed.error());
+    if (parsed) {
+      expected = parsed->part(part)();
+    }
+    if (has_both) {
+      std::expected<AnswerType, std::string> actual =
+          std::unexpected(both ? "" : both.error());
+      if (both) {
+        actual = part == 1 ? both->first : both->second;
+      }
+      compare(part, "solve_both", expected, actual);
+    }
+    for (const auto &variant : day.variants) {
+      if (variant.part == part) {
+        compare(part, variant.name, expected, variant.solve(input));
+      }
+    }
+  }
+  return result;
+}
+
+// Set by a day's main() before run_day() when its parts share no mutable
+// state, so the harness may run them at the same time.
+inline bool independent_parts = false;
+
+// Whether to run the parts at the same time. AOC_SEQUENTIAL keeps them apart,
+// e.g. to get perf and allocation counts per part.
+inline bool run_parts_concurrently() {
+  return independent_parts && !std::getenv("AOC_SEQUENTIAL");
+}
+
+template <typename AnswerType> struct TimedAnswer {
+  std::expected<AnswerType, std::string> answer;
+  int64_t microseconds;
+};
+
+template <typename AnswerType>
+TimedAnswer<AnswerType> run_timed(int part,
+                                  const BoundPart<AnswerType> &solve) {
+  TraceScope scope(part == 1 ? "part_one" : "part_two");
+  const auto start = std::chrono::steady_clock::now();
+  auto answer = solve();
+  return {std::move(answer), microseconds_since(start)};
+}
+
+// Runs part two on the thread pool while this thread runs part one.
+template <typename AnswerType>
+std::pair<TimedAnswer<AnswerType>, TimedAnswer<AnswerType>>
+run_concurrently(const ParsedInput<AnswerType> &parsed) {
+  auto &pool = thread_pool();
+  auto part_two =
+      pool.submit([&] { return run_timed<AnswerType>(2, parsed.part_two); });
+  std::optional<TimedAnswer<AnswerType>> part_one;
+  std::exception_ptr error;
+  try {
+    part_one = run_timed<AnswerType>(1, parsed.part_one);
+  } catch (...) {
+    error = std::current_exception();
+  }
+  // Part two refers to `parsed`, so it has to finish even if part one threw.
+  auto part_two_answer = pool.get(part_two);
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  return {std::move(*part_one), std::move(part_two_answer)};
+}
+
+// Batch mode, see batch.hpp. Solver logs go to stderr so stdout only carries
+// the responses.
+template <typename AnswerType>
+int run_batch(const Day<AnswerType> &day, const std::string &mode) {
+  std::cout.rdbuf(std::cerr.rdbuf());
+  auto solve = [&](const Frame &frame, std::string &response) {
+    auto start = std::chrono::steady_clock::now();
+    std::expected<ParsedInput<AnswerType>, std::string> parsed;
+    {
+      TraceScope scope("parse");
+      try {
+        parsed = day.parse(frame.input);
+      } catch (...) {
+        parsed = std::unexpected("solver threw");
+      }
+    }
+    if (day.parses) {
+      std::format_to(std::back_inserter(response), "{}\tparse\t{}\t{}\n",
+                     frame.name,
+                     parsed ? "ok" : std::format("error: {}", parsed.error()),
+                     microseconds_since(start));
+    }
+
+    if (frame.part == "both" && parsed && parsed->both) {
+      TraceScope scope("solve_both");
+      start = std::chrono::steady_clock::now();
+      BothAnswers<AnswerType> both;
+      try {
+        both = parsed->both();
+      } catch (...) {
+        both = std::unexpected("solver threw");
+      }
+      const auto microseconds = microseconds_since(start);
+      for (const int part : {1, 2}) {
+        std::expected<AnswerType, std::string> answer =
+            std::unexpected(both ? "" : both.error());
+        if (both) {
+          answer = part == 1 ? both->first : both->second;
+        }
+        std::format_to(std::back_inserter(response), "{}\t{}\t{}\t{}\n",
+                       frame.name, part, format_answer(answer), microseconds);
+      }
+      return;
+    }
+
+    if (frame.part == "both" && parsed && run_parts_concurrently()) {
+      std::pair<TimedAnswer<AnswerType>, TimedAnswer<AnswerType>> answers;
+      try {
+        answers = run_concurrently(*parsed);
+      } catch (...) {
+        answers.first.answer = answers.second.answer =
+            std::unexpected("solver threw");
+      }
+      for (const auto &[part, answer] :
+           {std::pair{1, &answers.first}, std::pair{2, &answers.second}}) {
+        std::format_to(std::back_inserter(response), "{}\t{}\t{}\t{}\n",
+                       frame.name, part, format_answer(answer->answer),
+                       answer->microseconds);
+      }
+      return;
+    }
+
+    for (const int part : {1, 2}) {
+      if (frame.part != "both" && frame.part != std::to_string(part)) {
+        continue;
+      }
+      TraceScope scope(part == 1 ? "part_one" : "part_two");
+      start = std::chrono::steady_clock::now();
+      std::expected<AnswerType, std::string> answer =
+          std::unexpected(parsed ? "" : parsed.error());
+      if (parsed) {
+        try {
+          answer = parsed->part(part)();
+        } catch (...) {
+          answer = std::unexpected("solver threw");
+        }
+      }
+      std::format_to(std::back_inserter(response), "{}\t{}\t{}\t{}\n",
+                     frame.name, part, format_answer(answer),
+                     microseconds_since(start));
+    }
+  };
+  // A server runs for as long as it is fed, so its trace is written out per
+  // input instead of piling up until exit.
+  auto handle = [&](const Frame &frame, std::string &response) {
+    solve(frame, response);
+    trace_session.flush();
+  };
+  if (mode == "socket") {
+    return serve_socket(std::getenv("AOC_SOCKET"), handle);
+  }
+  if (mode == "files") {
+    const char *part = std::getenv("AOC_PART");
+    return serve_files(part ? part : "both", handle);
+  }
+  return serve_frames(STDIN_FILENO, STDOUT_FILENO, handle);
+}
+
+// Parses the input (timed on its own for days with parse_input()), runs both
+// parts on it, in one pass for days with solve_both(), and prints the summary.
+template <typename AnswerType>
+int run_parts(const Day<AnswerType> &day, const std::string &input) {
+  std::expected<ParsedInput<AnswerType>, std::string> parsed;
+  std::optional<Measurement> parse_measurement;
+  if (day.parses) {
+    auto [result, measurement] =
+        measure("PARSE", "parse", [&] { return day.parse(input); });
+    parsed = std::move(result);
+    parse_measurement = std::move(measurement);
+  } else {
+    parsed = day.parse(input);
+  }
+  if (!parsed) {
+    std::println(std::cout, "\033[1;31m{}\033[0m", parsed.error());
+    return 1;
+  }
+
+  auto print_header = [&] {
+    std::println(std::cout, "-----------------------------------------");
+    std::println(std::cout, "Day {}", day.number);
+    if (parse_measurement) {
+      std::println(std::cout, "\tParse");
+      print_measurement(*parse_measurement);
+    }
+  };
+  if (parsed->both) {
+    const auto [answers, measurement] = run_both(parsed->both);
+    print_header();
+    std::println(std::cout, "\tPart 1");
+    std::println(std::cout, "\t\tAnswer: {}", answers.first);
+    std::println(std::cout, "\tPart 2");
+    std::println(std::cout, "\t\tAnswer: {}", answers.second);
+    std::println(std::cout, "\tBoth parts");
+    print_measurement(measurement);
+  } else if (run_parts_concurrently()) {
+    // Perf and allocation counts can't be told apart between the parts, so
+    // they only get their times and the counts cover both. A part's time runs
+    // until its answer is ready, which can include helping with the other
+    // part's tasks on the pool.
+    const auto [timed, measurement] = measure(
+        "PARTS 1 AND 2", "parts", [&] { return run_concurrently(*parsed); });
+    const AnswerType part_one = answer_or_zero(timed.first.answer);
+    const AnswerType part_two = answer_or_zero(timed.second.answer);
+    print_header();
+    for (const auto &[part, answer, microseconds] :
+         {std::tuple{1, part_one, timed.first.microseconds},
+          std::tuple{2, part_two, timed.second.microseconds}}) {
+      std::println(std::cout, "\tPart {}", part);
+      std::println(std::cout, "\t\tAnswer: {}", answer);
+      print_took(microseconds);
+    }
+    std::println(std::cout, "\tBoth parts (concurrently)");
+    print_measurement(measurement);
+  } else {
+    const auto part_one_report = run_part<AnswerType>(1, parsed->part_one);
+    const auto part_two_report = run_part<AnswerType>(2, parsed->part_two);
+    print_header();
+    print_part_report(1, part_one_report);
+    print_part_report(2, part_two_report);
+  }
+  std::println(std::cout, "-----------------------------------------");
+  return 0;
+}
+
+// How host.cpp runs a day it loaded as a shared object.
+struct HostedDay {
+  std::function<int(const std::string &input)> run;
+};
+
+#ifdef AOC_SHARED
+// Looked up by host.cpp with dlsym() after loading the day.
+extern "C" {
+HostedDay aoc_hosted_day;
+}
+#endif
+
+// Reads the input from stdin, runs both parts and prints the summary. With
+// AOC_DIFF set in the environment it instead compares the parts against their
+// registered variants, and with AOC_BATCH or AOC_SOCKET it solves many inputs
+// (see batch.hpp). AOC_BATCH=files reads a list of paths instead of framed
+// inputs, with the parts in AOC_PART.
+//
+// Built with -DAOC_SHARED it only registers the day in aoc_hosted_day for
+// host.cpp, which calls main() after loading it.
+template <typename AnswerType> int run_day(const Day<AnswerType> &day) {
+#ifdef AOC_SHARED
+  aoc_hosted_day.run = [day](const std::string &input) {
+    return run_parts(day, input);
+  };
+  return 0;
+#endif
+  if (std::getenv("AOC_SOCKET")) {
+    return run_batch(day, "socket");
+  }
+  if (const char *mode = std::getenv("AOC_BATCH")) {
+    return run_batch(day, mode);
+  }
+
+  std::ostringstream buffer;
+  buffer << std::cin.rdbuf();
+  std::string input = buffer.str();
+
+  if (std::getenv("AOC_DIFF")) {
+    return run_diff(day, input);
+  }
+  return run_parts(day, input);
+}
+
+#ifdef AOC_EMBED_INPUT
+// The input the compile-time mode solves, as a list of bytes generated by
+// `make BUILD=embed`.
+constexpr char embedded_input[] = {
+#include AOC_EMBED_INPUT
+};
+
+// Evaluates a part on the embedded input while compiling.
+template <typename AnswerType, auto Part>
+consteval std::optional<AnswerType> solve_embedded() {
+  const auto answer = Part(std::string(std::begin(embedded_input),
+                                        std::end(embedded_input)));
+  return answer ? std::optional<AnswerType>(*answer) : std::nullopt;
+}
+
+template <typename AnswerType, auto Parse, auto Part>
+consteval std::optional<AnswerType> solve_embedded() {
+  const std::expected<parsed_type<decltype(Parse)>, std::string> parsed =
+      Parse(std::string_view(embedded_input, sizeof(embedded_input)));
+  if (!parsed) {
+    return std::nullopt;
+  }
+  const auto answer = Part(*parsed);
+  return answer ? std::optional<AnswerType>(*answer) : std::nullopt;
+}
+
+template <typename AnswerType>
+int print_embedded(int day, std::optional<AnswerType> part_one,
+                   std::optional<AnswerType> part_two) {
+  std::println(std::cout, "-----------------------------------------");
+  std::println(std::cout, "Day {} (solved at compile time)", day);
+  print_part_report(1, PartReport<AnswerType>{*part_one});
+  print_part_report(2, PartReport<AnswerType>{*part_two});
+  std::println(std::cout, "-----------------------------------------");
+  return 0;
+}
+#endif
+
+// Shared main() for days whose parts take the input text.
+template <typename AnswerType, typename PartOne, typename PartTwo>
+int run_day(int day, PartOne &&part_one, PartTwo &&part_two,
+            const std::vector<Variant<AnswerType>> &variants = {}) {
+#ifdef AOC_EMBED_INPUT
+  static_assert(sizeof(AnswerType) == 0,
+                "Only days with constexpr parts can be solved at compile "
+                "time, see run_day<AnswerType, PartOne, PartTwo>()");
+#endif
+  return run_day(
+      make_day<AnswerType>(day, part_one, part_two, nullptr, variants));
+}
+
+// Same, for days that can also solve both parts in one pass with
+// solve_both(input), which the harness then runs instead of the parts.
+template <typename AnswerType, typename PartOne, typename PartTwo,
+          typename SolveBoth>
+  requires std::same_as<std::invoke_result_t<SolveBoth, const std::string &>,
+                        BothAnswers<AnswerType>>
+int run_day(int day, PartOne &&part_one, PartTwo &&part_two,
+            SolveBoth &&solve_both,
+            const std::vector<Variant<AnswerType>> &variants = {}) {
+#ifdef AOC_EMBED_INPUT
+  static_assert(sizeof(AnswerType) == 0,
+                "Only days with constexpr parts can be solved at compile "
+                "time, see run_day<AnswerType, PartOne, PartTwo>()");
+#endif
+  return run_day(
+      make_day<AnswerType>(day, part_one, part_two, solve_both, variants));
+}
+
+// Shared main() for days that parse once with parse_input(string_view) and
+// solve both parts from its result.
+template <typename AnswerType, typename Parse, typename PartOne,
+          typename PartTwo>
+  requires std::invocable<Parse, std::string_view>
+int run_day(int day, Parse &&parse_input, PartOne &&part_one,
+            PartTwo &&part_two,
+            const std::vector<Variant<AnswerType>> &variants = {}) {
+#ifdef AOC_EMBED_INPUT
+  static_assert(sizeof(AnswerType) == 0,
+                "Only days with constexpr parts can be solved at compile "
+                "time, see run_day<AnswerType, Parse, PartOne, PartTwo>()");
+#endif
+  return run_day(make_day<AnswerType>(day, parse_input, part_one, part_two,
+                                      nullptr, variants));
+}
+
+// Same, with solve_both(parsed) solving both parts in one pass.
+template <typename AnswerType, typename Parse, typename PartOne,
+          typename PartTwo, typename SolveBoth>
+  requires std::invocable<Parse, std::string_view>
+int run_day(int day, Parse &&parse_input, PartOne &&part_one,
+            PartTwo &&part_two, SolveBoth &&solve_both,
+            const std::vector<Variant<AnswerType>> &variants = {}) {
+#ifdef AOC_EMBED_INPUT
+  static_assert(sizeof(AnswerType) == 0,
+                "Only days with constexpr parts can be solved at compile "
+                "time, see run_day<AnswerType, Parse, PartOne, PartTwo>()");
+#endif
+  return run_day(make_day<AnswerType>(day, parse_input, part_one, part_two,
+                                      solve_both, variants));
+}
+
+// main() for days whose parts (and parse_input()) are constexpr. Built with
+// -DAOC_EMBED_INPUT (see `make BUILD=embed`) the compiler solves the embedded
+// input and the binary only prints the answers. Otherwise they are the
+// run_day() overloads above.
+template <typename AnswerType, auto PartOne, auto PartTwo>
+int run_day(int day, const std::vector<Variant<AnswerType>> &variants = {}) {
+#ifdef AOC_EMBED_INPUT
+  constexpr auto part_one = solve_embedded<AnswerType, PartOne>();
+  constexpr auto part_two = solve_embedded<AnswerType, PartTwo>();
+  static_assert(part_one, "part one failed on the embedded input");
+  static_assert(part_two, "part two failed on the embedded input");
+  return print_embedded<AnswerType>(day, part_one, part_two);
+#else
+  return run_day<AnswerType>(day, PartOne, PartTwo, variants);
+#endif
+}
+
+template <typename AnswerType, auto Parse, auto PartOne, auto PartTwo>
+int run_day(int day, const std::vector<Variant<AnswerType>> &variants = {}) {
+#ifdef AOC_EMBED_INPUT
+  constexpr auto part_one = solve_embedded<AnswerType, Parse, PartOne>();
+  constexpr auto part_two = solve_embedded<AnswerType, Parse, PartTwo>();
+  static_assert(part_one, "part one failed on the embedded input");
+  static_assert(part_two, "part two failed on the embedded input");
+  return print_embedded<AnswerType>(day, part_one, part_two);
+#else
+  return run_day<AnswerType>(day, Parse, PartOne, PartTwo, variants);
+#endif
+}
+
+// The compiler solves the parts separately, since solve_both() would only
+// save compile time.
+template <typename AnswerType, auto Parse, auto PartOne, auto PartTwo,
+          auto SolveBoth>
+int run_day(int day, const std::vector<Variant<AnswerType>> &variants = {}) {
+#ifdef AOC_EMBED_INPUT
+  return run_day<AnswerType, Parse, PartOne, PartTwo>(day, variants);
+#else
+  return run_day<AnswerType>(day, Parse, PartOne, PartTwo, SolveBoth,
+                             variants);
+#endif
+}
+
 struct Point {
   int x, y;
 
@@ -172,8 +1172,7 @@ struct Point {
 namespace std {
 template <> struct hash<Point> {
   inline size_t operator()(const Point &v) const {
-    hash<int> int_hasher;
-    return int_hasher(v.x) ^ int_hasher(v.y);
+    return hash_pair32(v.x, v.y);
   }
 };
 }; // namespace std
@@ -191,7 +1190,7 @@ namespace std {
 template <> struct hash<Line> {
   inline size_t operator()(const Line &v) const {
     hash<Point> point_hasher;
-    return point_hasher(v.a) ^ point_hasher(v.b);
+    return hash_combine(point_hasher(v.a), point_hasher(v.b));
   }
 };
 }; // namespace std
@@ -199,8 +1198,7 @@ template <> struct hash<Line> {
 namespace std {
 template <> struct hash<std::pair<uint64_t, uint64_t>> {
   inline size_t operator()(const std::pair<uint64_t, uint64_t> &v) const {
-    hash<uint64_t> hasher;
-    return hasher(v.first) ^ hasher(v.second);
+    return hash_combine(mix64(v.first), v.second);
   }
 };
 }; // namespace std
@@ -208,39 +1206,629 @@ template <> struct hash<std::pair<uint64_t, uint64_t>> {
 namespace std {
 template <> struct hash<std::vector<int>> {
   inline size_t operator()(const std::vector<int> &v) const {
-    hash<int> int_hasher{};
-    size_t h = int_hasher(v.size());
+    uint64_t h = mix64(v.size());
     for (const auto &e : v) {
-      h ^= int_hasher(e);
+      h = hash_combine(h, e);
     }
     return h;
   }
 };
 }; // namespace std
 
+// A grid of chars, either viewing the input text in place or owning a padded
+// copy of it. Every line of the input has to be as wide as the first. A view's
+// rows are where they are in the input, stride = width + 1 apart for the
+// newlines, so the input has to outlive it. A copy surrounds the grid with
+// `padding` rows and columns of `border` in a cache line aligned buffer, so
+// anything up to `padding` steps outside the grid can be read and compared
+// against instead of bounds checked.
+//
+// operator() and operator[] don't check bounds, at() does. Copies of a grid
+// share the buffer, since nothing writes to it.
 struct CharGrid {
-  std::vector<char> vec;
-  size_t width, height;
-  CharGrid(const std::string &input) {
-    std::istringstream lines(input);
-    std::string line;
-    while (getline(lines, line)) {
-      width = line.size();
-      for (const char c : line) {
-        vec.push_back(c);
+  struct alignas(64) CacheLine {
+    char chars[64];
+  };
+
+  size_t width = 0, height = 0;
+  // From the start of a row to the start of the next.
+  size_t stride = 0;
+  size_t padding = 0;
+  char border = '\0';
+  // The cell (0, 0).
+  const char *origin = nullptr;
+  std::shared_ptr<CacheLine[]> storage;
+
+  CharGrid() = default;
+
+  explicit CharGrid(std::string_view input, size_t padding = 1,
+                    char border = '\0')
+      : padding(padding), border(border) {
+    const char *rows = find_rows(input);
+    stride = width + 2 * padding;
+    const size_t size = stride * (height + 2 * padding);
+    storage.reset(new CacheLine[(size + sizeof(CacheLine) - 1) /
+                                sizeof(CacheLine)]);
+    char *base = storage[0].chars;
+    std::fill_n(base, size, border);
+    char *cells = base + padding * stride + padding;
+    for (size_t y = 0; y < height; ++y) {
+      std::copy_n(rows + y * (width + 1), width, cells + index(0, y));
+    }
+    origin = cells;
+  }
+
+  static CharGrid view(std::string_view input) {
+    CharGrid grid;
+    grid.origin = grid.find_rows(input);
+    grid.stride = grid.width + 1;
+    return grid;
+  }
+
+  // Sets the width and height, and returns where the first row starts.
+  const char *find_rows(std::string_view input) {
+    const size_t first = input.find_first_not_of('\n');
+    if (first == std::string_view::npos) {
+      width = height = 0;
+      return input.data();
+    }
+    const size_t last = input.find_last_not_of('\n');
+    input = input.substr(first, last + 1 - first);
+    width = std::min(input.find('\n'), input.size());
+    height = (input.size() + 1) / (width + 1);
+    return input.data();
+  }
+
+  // The offset of a cell from (0, 0), which works for cells in the padding
+  // too. Adding offset(dx, dy) to it moves by (dx, dy).
+  constexpr ptrdiff_t index(ptrdiff_t x, ptrdiff_t y) const {
+    return x + y * ptrdiff_t(stride);
+  }
+  constexpr ptrdiff_t offset(ptrdiff_t dx, ptrdiff_t dy) const {
+    return index(dx, dy);
+  }
+
+  // Right, down, left and up.
+  constexpr std::array<ptrdiff_t, 4> neighbors4() const {
+    return {offset(1, 0), offset(0, 1), offset(-1, 0), offset(0, -1)};
+  }
+
+  // neighbors4() followed by the diagonals.
+  constexpr std::array<ptrdiff_t, 8> neighbors8() const {
+    return {offset(1, 0),  offset(0, 1),  offset(-1, 0), offset(0, -1),
+            offset(1, 1),  offset(-1, 1), offset(-1, -1), offset(1, -1)};
+  }
+
+  char operator[](ptrdiff_t index) const { return origin[index]; }
+  char operator()(ptrdiff_t x, ptrdiff_t y) const {
+    return origin[index(x, y)];
+  }
+
+  char at(ptrdiff_t x, ptrdiff_t y) const {
+    if (!contains(x, y)) {
+      throw std::out_of_range(std::format("({}, {}) is outside the {}x{} grid",
+                                          x, y, width, height));
+    }
+    return (*this)(x, y);
+  }
+
+  constexpr bool contains(ptrdiff_t x, ptrdiff_t y) const {
+    return x >= 0 && x < ptrdiff_t(width) && y >= 0 && y < ptrdiff_t(height);
+  }
+
+  std::span<const char> row(size_t y) const {
+    return {origin + index(0, y), width};
+  }
+};
+
+// A bit per cell of a width x height grid, for marking cells visited. With
+// more than one layer (e.g. one per direction) a cell has a bit per layer.
+// Nothing is bounds checked. Clearing, counting and combining grids of the
+// same size go a 64 bit word at a time.
+struct BitGrid {
+  size_t width = 0, height = 0, layers = 1;
+  std::vector<uint64_t> words;
+
+  BitGrid() = default;
+  BitGrid(size_t width, size_t height, size_t layers = 1)
+      : width(width), height(height), layers(layers),
+        words((width * height * layers + 63) / 64) {}
+  explicit BitGrid(const CharGrid &grid, size_t layers = 1)
+      : BitGrid(grid.width, grid.height, layers) {}
+
+  size_t bit(size_t x, size_t y, size_t layer = 0) const {
+    return (layer * height + y) * width + x;
+  }
+
+  bool test(size_t x, size_t y, size_t layer = 0) const {
+    const size_t i = bit(x, y, layer);
+    return words[i / 64] >> (i % 64) & 1;
+  }
+
+  void set(size_t x, size_t y, size_t layer = 0) {
+    const size_t i = bit(x, y, layer);
+    words[i / 64] |= uint64_t(1) << (i % 64);
+  }
+
+  void clear(size_t x, size_t y, size_t layer = 0) {
+    const size_t i = bit(x, y, layer);
+    words[i / 64] &= ~(uint64_t(1) << (i % 64));
+  }
+
+  // Sets the bit and returns what it was, like inserting into a set.
+  bool test_and_set(size_t x, size_t y, size_t layer = 0) {
+    const size_t i = bit(x, y, layer);
+    const uint64_t mask = uint64_t(1) << (i % 64);
+    const bool was_set = words[i / 64] & mask;
+    words[i / 64] |= mask;
+    return was_set;
+  }
+
+  void clear() { std::fill(words.begin(), words.end(), 0); }
+
+  size_t count() const {
+    size_t result = 0;
+    for (const uint64_t word : words) {
+      result += std::popcount(word);
+    }
+    return result;
+  }
+
+  BitGrid &operator|=(const BitGrid &rhs) {
+    for (size_t i = 0; i < words.size(); ++i) {
+      words[i] |= rhs.words[i];
+    }
+    return *this;
+  }
+
+  BitGrid &operator&=(const BitGrid &rhs) {
+    for (size_t i = 0; i < words.size(); ++i) {
+      words[i] &= rhs.words[i];
+    }
+    return *this;
+  }
+
+  // Clears the bits set in rhs.
+  BitGrid &and_not(const BitGrid &rhs) {
+    for (size_t i = 0; i < words.size(); ++i) {
+      words[i] &= ~rhs.words[i];
+    }
+    return *this;
+  }
+};
+
+// Right, down, left and up, as (dx, dy).
+constexpr std::array<std::pair<int, int>, 4> STEPS4 = {
+    {{1, 0}, {0, 1}, {-1, 0}, {0, -1}}};
+
+// Flood fills a grid breadth first from a start cell, with a queue instead of
+// recursion, so the size of a region is limited by memory instead of the
+// stack. can_step(from, to) says whether a neighbor in the grid can be
+// stepped to, and visit(cell) is called once for every cell reached, start
+// included, in the order they are reached.
+//
+// Cells stay visited across fill()s, so one search can flood every region of
+// a grid in turn. reset() unmarks only what the last fill() reached, so
+// searching from many starts costs what each reaches, not the grid's size.
+//
+// A search can be limited to rows [first_row, last_row), e.g. a RowBand's
+// read rows, and then only marks those, so it costs their size instead of the
+// grid's.
+struct GridSearch {
+  const CharGrid *grid;
+  size_t first_row, last_row;
+  // Rows counted from first_row.
+  BitGrid visited;
+  // The cells the last fill() reached, which were also its queue.
+  std::vector<Point> reached;
+
+  explicit GridSearch(const CharGrid &grid)
+      : GridSearch(grid, 0, grid.height) {}
+  GridSearch(const CharGrid &grid, size_t first_row, size_t last_row)
+      : grid(&grid), first_row(first_row), last_row(last_row),
+        visited(grid.width, last_row - first_row) {}
+
+  bool contains(const Point &cell) const {
+    return cell.x >= 0 && cell.x < ptrdiff_t(grid->width) &&
+           cell.y >= ptrdiff_t(first_row) && cell.y < ptrdiff_t(last_row);
+  }
+
+  template <typename CanStep, typename Visit>
+  void fill(Point start, CanStep &&can_step, Visit &&visit) {
+    reached.clear();
+    if (visited.test_and_set(start.x, start.y - first_row)) {
+      return;
+    }
+    reached.push_back(start);
+    for (size_t i = 0; i < reached.size(); ++i) {
+      const Point cell = reached[i];
+      visit(cell);
+      for (const auto &[dx, dy] : STEPS4) {
+        const Point next(cell.x + dx, cell.y + dy);
+        if (contains(next) && !visited.test(next.x, next.y - first_row) &&
+            can_step(cell, next)) {
+          visited.set(next.x, next.y - first_row);
+          reached.push_back(next);
+        }
       }
     }
-    height = vec.size() / width;
   }
 
-  inline size_t index(size_t x, size_t y) const { return x + y * width; }
+  void reset() {
+    for (const Point &cell : reached) {
+      visited.clear(cell.x, cell.y - first_row);
+    }
+    reached.clear();
+  }
+};
+
+// A cell and the direction it faces, an index into STEPS4, which is the state
+// of searches where turning costs something. Searches over cells alone leave
+// the direction 0.
+struct GridState {
+  int x, y;
+  int direction = 0;
+
+  GridState forward(int distance = 1) const {
+    const auto &[dx, dy] = STEPS4[direction];
+    return {x + dx * distance, y + dy * distance, direction};
+  }
+  // Clockwise, or counterclockwise for negative turns.
+  GridState turned(int turns) const { return {x, y, (direction + turns) & 3}; }
 
-  char &at(size_t x, size_t y) { return vec.at(index(x, y)); }
+  bool operator==(const GridState &rhs) const = default;
+};
+
+// A monotone priority queue of uint32_t keys: pushing a key below the last
+// popped one is not allowed, which shortest path searches never do. An item
+// is kept in the bucket of the highest bit where its key differs from the
+// last popped key, so it moves down a bucket at most once per bit instead of
+// being sifted through a binary heap on every push and pop.
+template <typename Value> struct RadixHeap {
+  std::array<std::vector<std::pair<uint32_t, Value>>, 33> buckets;
+  uint32_t last = 0;
+  size_t size = 0;
+
+  size_t bucket(uint32_t key) const { return std::bit_width(key ^ last); }
+
+  bool empty() const { return size == 0; }
+
+  void push(uint32_t key, Value value) {
+    buckets[bucket(key)].emplace_back(key, std::move(value));
+    ++size;
+  }
+
+  // The item with the smallest key, ties in no particular order.
+  std::pair<uint32_t, Value> pop() {
+    if (buckets[0].empty()) {
+      size_t i = 1;
+      while (buckets[i].empty()) {
+        ++i;
+      }
+      // Everything in bucket i differs from the new last key below bit i, so
+      // it all lands in lower buckets.
+      last = std::ranges::min(buckets[i], {}, [](const auto &item) {
+               return item.first;
+             }).first;
+      for (auto &item : buckets[i]) {
+        buckets[bucket(item.first)].push_back(std::move(item));
+      }
+      buckets[i].clear();
+    }
+    auto item = std::move(buckets[0].back());
+    buckets[0].pop_back();
+    --size;
+    return item;
+  }
 
-  const char &at(size_t x, size_t y) const { return vec.at(index(x, y)); }
+  void clear() {
+    for (auto &bucket : buckets) {
+      bucket.clear();
+    }
+    last = 0;
+    size = 0;
+  }
+};
+
+// Shortest paths over the states of a grid, kept in arrays indexed by state
+// rather than in maps. Directions is 1 to search cells, or 4 to search cells
+// and the direction they are faced in.
+//
+// The searches start from every state in starts, at distance 0, and call
+// edges(from, relax) for the moves out of each state they settle, which calls
+// relax(to, cost) for each move; moves off the grid are ignored. bfs01() needs
+// every cost to be 0 or 1. a_star() needs a heuristic that never overestimates
+// and drops by no more than the cost of any move, dijkstra() is a_star()
+// without one. They stop at the first state is_goal accepts and return its
+// distance, or UNREACHED if there is none, after which goal is the state they
+// stopped at and distance() is final for it and everything settled before it.
+//
+// With track_paths, path_to() gives the states along a path to a reached
+// state, a shortest one for the goal. The arrays are reused between searches.
+template <int Directions> struct GridPaths {
+  static_assert(Directions == 1 || Directions == 4);
+  static constexpr uint32_t UNREACHED = std::numeric_limits<uint32_t>::max();
+  static constexpr uint32_t NO_STATE = std::numeric_limits<uint32_t>::max();
+
+  struct NoGoal {
+    bool operator()(const GridState &) const { return false; }
+  };
+
+  const CharGrid *grid;
+  bool track_paths;
+  std::vector<uint32_t> distances;
+  // The state each state was last shortened from, with track_paths.
+  std::vector<uint32_t> previous;
+  RadixHeap<uint32_t> heap;
+  // (distance, state), for bfs01().
+  std::deque<std::pair<uint32_t, uint32_t>> queue;
+  GridState goal{-1, -1};
+
+  explicit GridPaths(const CharGrid &grid, bool track_paths = false)
+      : grid(&grid), track_paths(track_paths) {
+    const size_t states = grid.width * grid.height * Directions;
+    if (states >= NO_STATE) {
+      throw std::length_error(std::format(
+          "{}x{} grid has too many states to search", grid.width, grid.height));
+    }
+    distances.resize(states);
+    if (track_paths) {
+      previous.resize(states);
+    }
+  }
+
+  uint32_t state(const GridState &s) const {
+    return (uint32_t(s.y) * grid->width + s.x) * Directions +
+           s.direction % Directions;
+  }
+
+  GridState unpack(uint32_t state) const {
+    const uint32_t cell = state / Directions;
+    return {int(cell % grid->width), int(cell / grid->width),
+            int(state % Directions)};
+  }
+
+  uint32_t distance(const GridState &s) const { return distances[state(s)]; }
+
+  template <typename Edges, typename IsGoal = NoGoal>
+  uint32_t bfs01(const std::vector<GridState> &starts, Edges &&edges,
+                 IsGoal &&is_goal = {}) {
+    queue.clear();
+    restart(starts, [&](uint32_t s, const GridState &) {
+      queue.emplace_back(0, s);
+    });
+    while (!queue.empty()) {
+      const uint32_t distance = queue.front().first;
+      const uint32_t s = queue.front().second;
+      queue.pop_front();
+      // Shortened after this was queued, and already settled.
+      if (distance != distances[s]) {
+        continue;
+      }
+      const GridState from = unpack(s);
+      if (is_goal(from)) {
+        goal = from;
+        return distance;
+      }
+      edges(from, [&](const GridState &to, uint32_t cost) {
+        const uint32_t next = relax(s, distance, to, cost);
+        if (next == NO_STATE) {
+          return;
+        }
+        if (cost == 0) {
+          queue.emplace_front(distance, next);
+        } else {
+          queue.emplace_back(distance + 1, next);
+        }
+      });
+    }
+    return UNREACHED;
+  }
+
+  template <typename Edges, typename IsGoal = NoGoal>
+  uint32_t dijkstra(const std::vector<GridState> &starts, Edges &&edges,
+                    IsGoal &&is_goal = {}) {
+    return a_star(
+        starts, edges, [](const GridState &) { return uint32_t(0); }, is_goal);
+  }
 
-  bool contains(size_t x, size_t y) const {
-    return x >= 0 && x < width && y >= 0 && y < height;
+  template <typename Edges, typename Heuristic, typename IsGoal = NoGoal>
+  uint32_t a_star(const std::vector<GridState> &starts, Edges &&edges,
+                  Heuristic &&heuristic, IsGoal &&is_goal = {}) {
+    heap.clear();
+    restart(starts, [&](uint32_t s, const GridState &start) {
+      heap.push(heuristic(start), s);
+    });
+    while (!heap.empty()) {
+      const auto [estimate, popped] = heap.pop();
+      const uint32_t s = popped;
+      const GridState from = unpack(s);
+      const uint32_t distance = distances[s];
+      if (estimate != distance + heuristic(from)) {
+        continue;
+      }
+      if (is_goal(from)) {
+        goal = from;
+        return distance;
+      }
+      edges(from, [&](const GridState &to, uint32_t cost) {
+        const uint32_t next = relax(s, distance, to, cost);
+        if (next != NO_STATE) {
+          heap.push(distances[next] + heuristic(to), next);
+        }
+      });
+    }
+    return UNREACHED;
+  }
+
+  // From the start it was reached from to s, or empty if it wasn't reached
+  // or paths aren't tracked.
+  std::vector<GridState> path_to(const GridState &s) const {
+    std::vector<GridState> path;
+    if (!track_paths || !grid->contains(s.x, s.y) ||
+        distance(s) == UNREACHED) {
+      return path;
+    }
+    for (uint32_t i = state(s); i != NO_STATE; i = previous[i]) {
+      path.push_back(unpack(i));
+    }
+    std::ranges::reverse(path);
+    return path;
+  }
+
+  // Forgets the last search and calls push(state, start) for each start.
+  template <typename Push>
+  void restart(const std::vector<GridState> &starts, Push &&push) {
+    std::ranges::fill(distances, UNREACHED);
+    goal = {-1, -1};
+    for (const GridState &start : starts) {
+      if (!grid->contains(start.x, start.y)) {
+        continue;
+      }
+      const uint32_t s = state(start);
+      if (distances[s] == 0) {
+        continue;
+      }
+      distances[s] = 0;
+      if (track_paths) {
+        previous[s] = NO_STATE;
+      }
+      push(s, start);
+    }
+  }
+
+  // Moves to `to` at cost from `from`, and returns its state if that is
+  // shorter than what it had, or NO_STATE.
+  uint32_t relax(uint32_t from, uint32_t distance, const GridState &to,
+                 uint32_t cost) {
+    if (!grid->contains(to.x, to.y)) {
+      return NO_STATE;
+    }
+    const uint32_t s = state(to);
+    if (distance + cost >= distances[s]) {
+      return NO_STATE;
+    }
+    distances[s] = distance + cost;
+    if (track_paths) {
+      previous[s] = from;
+    }
+    return s;
+  }
+};
+
+// A grid packed Bits (2 or 4) bits per cell, each cell holding the index of
+// its char in an alphabet, e.g. "XMAS" in 2 bits or the digits in 4. A row
+// starts on a new 64 bit word, so a whole word of cells of a row can be
+// compared at once with match(), and the masks it returns combined across
+// rows and shifted along them.
+template <int Bits> struct PackedGrid {
+  static_assert(Bits == 2 || Bits == 4);
+  static constexpr size_t CELLS_PER_WORD = 64 / Bits;
+  static constexpr uint64_t CELL_MASK = (uint64_t(1) << Bits) - 1;
+  // The lowest bit of every cell.
+  static constexpr uint64_t LOW_BITS = ~uint64_t(0) / CELL_MASK;
+
+  size_t width = 0, height = 0, words_per_row = 0;
+  std::vector<uint64_t> words;
+
+  static auto encode(const CharGrid &grid, std::string_view alphabet)
+      -> std::expected<PackedGrid, std::string> {
+    if (alphabet.size() > CELL_MASK + 1) {
+      return std::unexpected(std::format("\"{}\" doesn't fit in {} bits",
+                                         alphabet, Bits));
+    }
+    std::array<int, 256> codes;
+    codes.fill(-1);
+    for (size_t i = 0; i < alphabet.size(); ++i) {
+      codes[uint8_t(alphabet[i])] = i;
+    }
+
+    PackedGrid packed;
+    packed.width = grid.width;
+    packed.height = grid.height;
+    packed.words_per_row = (grid.width + CELLS_PER_WORD - 1) / CELLS_PER_WORD;
+    packed.words.resize(packed.words_per_row * grid.height);
+    for (size_t y = 0; y < grid.height; ++y) {
+      const auto cells = grid.row(y);
+      uint64_t *row = packed.words.data() + y * packed.words_per_row;
+      for (size_t w = 0; w < packed.words_per_row; ++w) {
+        const size_t first = w * CELLS_PER_WORD;
+        const size_t last = std::min(grid.width, first + CELLS_PER_WORD);
+        uint64_t word = 0;
+        // Negative once any code is, so the check is one branch per word.
+        int codes_or = 0;
+        for (size_t x = first; x < last; ++x) {
+          const int code = codes[uint8_t(cells[x])];
+          codes_or |= code;
+          word |= uint64_t(code & CELL_MASK) << ((x - first) * Bits);
+        }
+        if (codes_or < 0) {
+          for (size_t x = first; x < last; ++x) {
+            if (codes[uint8_t(cells[x])] < 0) {
+              return std::unexpected(
+                  std::format("'{}' at ({}, {}) is not one of \"{}\"",
+                              cells[x], x, y, alphabet));
+            }
+          }
+        }
+        row[w] = word;
+      }
+    }
+    return packed;
+  }
+
+  std::span<const uint64_t> row(size_t y) const {
+    return {words.data() + y * words_per_row, words_per_row};
+  }
+
+  uint8_t operator()(size_t x, size_t y) const {
+    return row(y)[x / CELLS_PER_WORD] >> (x % CELLS_PER_WORD * Bits) &
+           CELL_MASK;
+  }
+
+  // The low bits of the cells of word w of a row that are in the grid.
+  uint64_t valid(size_t w) const {
+    const size_t cells = width - w * CELLS_PER_WORD;
+    return cells >= CELLS_PER_WORD
+               ? LOW_BITS
+               : LOW_BITS & ((uint64_t(1) << cells * Bits) - 1);
+  }
+
+  // The low bit of every cell of word w of row y that holds code, and nothing
+  // else. XORing turns those cells to 0, then each cell's bits are ORed down
+  // into its low bit.
+  uint64_t match(size_t y, size_t w, uint8_t code) const {
+    uint64_t x = row(y)[w] ^ (LOW_BITS * code);
+    for (int shift = 1; shift < Bits; shift *= 2) {
+      x |= x >> shift;
+    }
+    return ~x & valid(w);
+  }
+
+  size_t count(size_t y, uint8_t code) const {
+    size_t result = 0;
+    for (size_t w = 0; w < words_per_row; ++w) {
+      result += std::popcount(match(y, w, code));
+    }
+    return result;
+  }
+
+  // Word w of a row of match() masks, moved so that cell x has what cell
+  // x + cells had. Cells from outside the row are 0. cells must be less than
+  // a word.
+  static uint64_t shift_cells(std::span<const uint64_t> masks, size_t w,
+                              int cells) {
+    if (cells == 0) {
+      return masks[w];
+    }
+    if (cells > 0) {
+      const int shift = cells * Bits;
+      const uint64_t next = w + 1 < masks.size() ? masks[w + 1] : 0;
+      return masks[w] >> shift | next << (64 - shift);
+    }
+    const int shift = -cells * Bits;
+    const uint64_t previous = w > 0 ? masks[w - 1] : 0;
+    return masks[w] << shift | previous >> (64 - shift);
   }
 };
 #endif // UTIL_HPP
@@ -14,5 +14,11 @@ fi
 
 # Run once before watching to make sure the code file has been created.
 $SCRIPT_ROOT/run.sh $DAY $2
-ls $SCRIPT_ROOT/run.sh $SCRIPT_ROOT/src/${DAY}.cpp $SCRIPT_ROOT/src/util.hpp |
+
+# Reload the day in place instead of relaunching it under gdb.
+if [ -n "$HOT_RELOAD" ]; then
+  exec $SCRIPT_ROOT/host.sh $DAY $2
+fi
+
+ls $SCRIPT_ROOT/run.sh $SCRIPT_ROOT/src/${DAY}.cpp $SCRIPT_ROOT/src/*.hpp |
     entr $SCRIPT_ROOT/run.sh $DAY $2